@@ -5,36 +5,758 @@
 #include <stdexcept>
 #include <algorithm>
 #include <climits>
+#include <memory>
+#include <cctype>
+#include <istream>
+#include <ostream>
+#include "operation_trace.h"
+#include "scratch_arena.h"
+#include "small_divisor.h"
+#include "thread_pool.h"
 
-big_integer::big_integer() : data(1, 0), sign(false) {}
+namespace {
+    const size_t KARATSUBA_THRESHOLD = 48;  //  при меньшей длине короткого множителя - школьное умножение
+    const size_t PARALLEL_THRESHOLD = 1024;  //  при меньшей длине подзадачи Карацубы не отдаются в пул
+    const size_t DIVEXACT_DC_THRESHOLD = 96;  //  более короткие частные деления нацело - школьным методом
+
+    std::unique_ptr<thread_pool> pool;
+
+    template<typename... F>
+    void invoke_all(const bool parallel, F &&... f) {
+        if (parallel) {
+            std::vector<thread_pool::task> tasks{f...};
+            pool->run(tasks);
+        } else {
+            int order[] = {(f(), 0)...};
+            static_cast<void>(order);
+        }
+    }
+
+    //  r[0, rn) += a[0, an), an <= rn, возвращает перенос
+    uint32_t add_to(uint32_t *r, const size_t rn, const uint32_t *a, const size_t an) {
+        uint64_t carry = 0;
+        size_t i = 0;
+        for (; i < an; ++i) {
+            carry += static_cast<uint64_t>(r[i]) + a[i];
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32u;
+        }
+        for (; carry != 0 && i < rn; ++i) {
+            carry += r[i];
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32u;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    //  r[0, rn) -= a[0, an), an <= rn, возвращает заем
+    uint32_t sub_from(uint32_t *r, const size_t rn, const uint32_t *a, const size_t an) {
+        uint32_t borrow = 0;
+        size_t i = 0;
+        for (; i < an; ++i) {
+            const uint64_t diff = static_cast<uint64_t>(r[i]) - a[i] - borrow;
+            r[i] = static_cast<uint32_t>(diff);
+            borrow = static_cast<uint32_t>(diff >> 63u);
+        }
+        for (; borrow != 0 && i < rn; ++i) {
+            borrow = r[i] == 0;
+            --r[i];
+        }
+        return borrow;
+    }
+
+    //  r[0, n) = a * b, возвращает старший разряд произведения
+    uint32_t mul_1(const uint32_t *a, const size_t n, const uint32_t b, uint32_t *r) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            carry += static_cast<uint64_t>(a[i]) * b;
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32u;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    //  r[0, n + 2) = a * (b1 * B + b0) за один проход по a
+    void mul_2(const uint32_t *a, const size_t n, const uint32_t b0, const uint32_t b1, uint32_t *r) {
+        uint64_t carry = 0, high = 0;  //  high = a[i - 1] * b1, еще не прибавленное к разряду i
+        for (size_t i = 0; i < n; ++i) {
+            //  a[i] * b0 + два 32-битных слагаемых не переполняют 64 бита
+            const uint64_t sum = static_cast<uint64_t>(a[i]) * b0 + static_cast<uint32_t>(high)
+                                 + static_cast<uint32_t>(carry);
+            r[i] = static_cast<uint32_t>(sum);
+            carry = (sum >> 32u) + (high >> 32u) + (carry >> 32u);
+            high = static_cast<uint64_t>(a[i]) * b1;
+        }
+        high += carry;  //  два старших разряда произведения, переполнения нет
+        r[n] = static_cast<uint32_t>(high);
+        r[n + 1] = static_cast<uint32_t>(high >> 32u);
+    }
+
+    //  r[0, n) += a * b, возвращает перенос
+    uint32_t addmul_1(const uint32_t *a, const size_t n, const uint32_t b, uint32_t *r) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            carry += static_cast<uint64_t>(a[i]) * b + r[i];
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32u;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    __extension__ typedef unsigned __int128 uint128;
+
+    //  пара разрядов как одно 64-битное слово, компилятор сводит к одному чтению и записи
+    uint64_t load_word(const uint32_t *p) {
+        return p[0] | static_cast<uint64_t>(p[1]) << 32u;
+    }
+
+    void store_word(uint32_t *p, const uint64_t value) {
+        p[0] = static_cast<uint32_t>(value);
+        p[1] = static_cast<uint32_t>(value >> 32u);
+    }
+
+    //  r[0, n + m) = a * b, n и m четные: школьное умножение блоками 2 x 2 разряда,
+    //  одно умножение 64 x 64 -> 128 вместо четырех 32 x 32 -> 64
+    void mul_words(const uint32_t *a, const size_t n, const uint32_t *b, const size_t m, uint32_t *r) {
+        std::fill(r, r + m, 0);
+        for (size_t i = 0; i < n; i += 2) {
+            const uint64_t word = load_word(a + i);
+            uint128 carry = 0;
+            for (size_t j = 0; j < m; j += 2) {
+                carry += static_cast<uint128>(word) * load_word(b + j) + load_word(r + i + j);
+                store_word(r + i + j, static_cast<uint64_t>(carry));
+                carry >>= 64u;
+            }
+            store_word(r + i + m, static_cast<uint64_t>(carry));
+        }
+    }
+
+    const size_t RADIX_DC_THRESHOLD = 64;  //  в чанках, более длинные строки переводятся разделяй и властвуй
+    const size_t RECIPROCAL_THRESHOLD = 64;  //  в разрядах, обратные к более коротким числам - делением Кнута
+    const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    const size_t WRITE_BLOCK_SIZE = 1u << 12u;  //  столько цифр копится перед записью в поток
+
+    void flush_digits(std::string &str, std::ostream *out) {
+        if (out) {
+            out->write(str.data(), static_cast<std::streamsize>(str.size()));
+            str.clear();
+        }
+    }
+
+    uint32_t stream_base(const std::ios_base &s) {
+        const auto field = s.flags() & std::ios_base::basefield;
+        return field == std::ios_base::hex ? 16 : field == std::ios_base::oct ? 8 : 10;
+    }
+
+    struct radix_chunk {
+        uint32_t base;  //  base^digits, наибольшая степень, помещающаяся в разряд
+        size_t digits;
+    };
+
+    void check_base(const uint32_t base) {
+        if (base < 2 || base > 36) {
+            throw std::runtime_error("Expected: base from 2 to 36, found: " + std::to_string(base));
+        }
+    }
+
+    bool is_power_of_two(const uint32_t base) {
+        return (base & (base - 1)) == 0;
+    }
+
+    radix_chunk chunk_of(const uint32_t base) {
+        radix_chunk chunk{base, 1};
+        while (static_cast<uint64_t>(chunk.base) * base <= UINT32_MAX) {
+            chunk.base *= base;
+            ++chunk.digits;
+        }
+        return chunk;
+    }
+
+    uint32_t any_digit_value(const char c) {  //  36, если это не цифра ни в одном основании
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        } else if (c >= 'a' && c <= 'z') {
+            return c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'Z') {
+            return c - 'A' + 10;
+        }
+        return 36;
+    }
+
+    uint32_t digit_value(const char c, const uint32_t base) {
+        const uint32_t value = any_digit_value(c);
+        if (value >= base) {
+            throw std::runtime_error("Expected: digit, found: " + std::string(1, c));
+        }
+        return value;
+    }
+
+    const size_t SERIALIZED_HEADER_SIZE = 8;
+
+    void store_le(uint8_t *p, const uint64_t value, const size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            p[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    uint64_t load_le(const uint8_t *p, const size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = bytes; i-- > 0;) {
+            value = (value << 8u) | p[i];
+        }
+        return value;
+    }
+
+    //  проверяет заголовок и каноничность записи, возвращает число разрядов
+    size_t parse_header(const uint8_t *p, const size_t bytes, bool &negative) {
+        if (bytes < SERIALIZED_HEADER_SIZE) {
+            throw std::runtime_error("Truncated serialized big_integer");
+        }
+        const uint64_t header = load_le(p, SERIALIZED_HEADER_SIZE);
+        const uint64_t n = header >> 1u;
+        negative = (header & 1u) != 0;
+        if (n == 0 || n > (bytes - SERIALIZED_HEADER_SIZE) / sizeof(uint32_t)) {
+            throw std::runtime_error("Truncated serialized big_integer");
+        }
+        const uint64_t top = load_le(p + SERIALIZED_HEADER_SIZE + (n - 1) * sizeof(uint32_t), sizeof(uint32_t));
+        if (top == 0 && (n > 1 || negative)) {
+            throw std::runtime_error("Non-canonical serialized big_integer");
+        }
+        return static_cast<size_t>(n);
+    }
+
+    //  r[0, n) -= a * b, возвращает заем
+    uint32_t submul_1(const uint32_t *a, const size_t n, const uint32_t b, uint32_t *r) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const uint64_t product = static_cast<uint64_t>(a[i]) * b + carry;
+            const auto low = static_cast<uint32_t>(product);
+            carry = (product >> 32u) + (r[i] < low);
+            r[i] -= low;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    //  b^-1 mod 2^32 для нечетного b: b * b = 1 mod 8, каждая итерация Ньютона удваивает число верных бит
+    uint32_t inverse_limb(const uint32_t b) {
+        uint32_t x = b;
+        for (size_t i = 0; i < 4; ++i) {
+            x *= 2 - b * x;
+        }
+        return x;
+    }
+
+    //  r[0, n) = a >> shift, shift < 32, старшие биты r[n - 1] берутся из high
+    void shift_right(const uint32_t *a, const size_t n, const uint32_t shift, const uint32_t high, uint32_t *r) {
+        if (shift == 0) {
+            std::copy(a, a + n, r);
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t next = i + 1 < n ? a[i + 1] : high;
+            r[i] = (a[i] >> shift) | (next << (32 - shift));
+        }
+    }
+
+    //  сравнение чисел одинаковой длины n
+    int compare_n(const uint32_t *a, const uint32_t *b, const size_t n) {
+        for (size_t i = n; i-- > 0;) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    //  r[0, n + m) = a * b, n >= m. Короче порога Карацубы b целиком лежит в L1,
+    //  так что блоки нужны только на уровне регистров: четные части - через mul_words,
+    //  нечетные последние разряды дописываются отдельными проходами
+    void mul_basecase(const uint32_t *a, const size_t n, const uint32_t *b, const size_t m, uint32_t *r) {
+        if (m == 1) {
+            r[n] = mul_1(a, n, b[0], r);
+            return;
+        } else if (m == 2) {
+            mul_2(a, n, b[0], b[1], r);
+            return;
+        }
+        const size_t ne = n & ~static_cast<size_t>(1), me = m & ~static_cast<size_t>(1);
+        mul_words(a, ne, b, me, r);
+        if (me != m) {
+            r[ne + me] = addmul_1(a, ne, b[me], r + me);
+        }
+        if (ne != n) {
+            r[ne + m] = addmul_1(b, m, a[ne], r + ne);
+        }
+    }
+
+    //  r[0, n + m) = a * b, Карацуба: a = a1 * B^h + a0, b = b1 * B^h + b0,
+    //  a * b = a1b1 * B^2h + ((a0 + a1)(b0 + b1) - a0b0 - a1b1) * B^h + a0b0
+    void mul(const uint32_t *a, size_t n, const uint32_t *b, size_t m, uint32_t *r) {
+        if (n < m) {
+            std::swap(a, b);
+            std::swap(n, m);
+        }
+        if (m < KARATSUBA_THRESHOLD) {
+            mul_basecase(a, n, b, m, r);
+            return;
+        }
+        const size_t h = n / 2;
+        const bool parallel = pool && m >= PARALLEL_THRESHOLD;
+        scratch_scope scratch;
+        if (m <= h) {
+            //  b не делится пополам: a режется на куски a_k длины m, a * b = sum a_k * b * B^km.
+            //  Произведения четных кусков не пересекаются и пишутся прямо в r, нечетных - в t = (r - r_четн) / B^m
+            const size_t chunks = (n + m - 1) / m;
+            uint32_t *t = scratch.allocate(n);
+            auto chunk = [=](const size_t k) {
+                const size_t len = std::min(m, n - k * m);
+                mul(a + k * m, len, b, m, k % 2 == 0 ? r + k * m : t + (k - 1) * m);
+            };
+            if (parallel) {
+                std::vector<thread_pool::task> tasks;
+                for (size_t k = 0; k < chunks; ++k) {
+                    tasks.push_back([=] { chunk(k); });
+                }
+                pool->run(tasks);
+            } else {
+                for (size_t k = 0; k < chunks; ++k) {
+                    chunk(k);
+                }
+            }
+            const size_t last_even = (chunks - 1) & ~static_cast<size_t>(1), last_odd = (chunks - 2) | 1u;
+            std::fill(r + std::min(n, last_even * m + m) + m, r + n + m, 0);
+            std::fill(t + std::min(n, last_odd * m + m), t + n, 0);
+            add_to(r + m, n, t, n);
+            return;
+        }
+        const size_t an = n - h, bn = m - h, sa_n = an + 1, sb_n = std::max(bn, h) + 1, z1_n = sa_n + sb_n;
+        uint32_t *sa = scratch.allocate(sa_n), *sb = scratch.allocate(sb_n), *z1 = scratch.allocate(z1_n);
+        std::copy(a + h, a + n, sa);
+        sa[an] = add_to(sa, an, a, h);
+        if (bn >= h) {
+            std::copy(b + h, b + m, sb);
+            sb[bn] = add_to(sb, bn, b, h);
+        } else {
+            std::copy(b, b + h, sb);
+            sb[h] = add_to(sb, h, b + h, bn);
+        }
+        invoke_all(parallel,
+                   [&] { mul(a, h, b, h, r); },
+                   [&] { mul(a + h, an, b + h, bn, r + 2 * h); },
+                   [&] { mul(sa, sa_n, sb, sb_n, z1); });
+        sub_from(z1, z1_n, r, 2 * h);
+        sub_from(z1, z1_n, r + 2 * h, an + bn);
+        add_to(r + h, n + m - h, z1, std::min(z1_n, n + m - h));  //  отброшенные старшие разряды z1 нулевые
+    }
+
+    //  r[0, qn) = r * d^-1 mod B^qn, d[0] нечетный, inverse = d[0]^-1 mod B: частное деления нацело.
+    //  Старшие разряды q влияют только на старшие разряды q * d, поэтому сначала находится младшая
+    //  половина частного, ее произведение на d вычитается из старшей половины r, и так же - старшая
+    void divexact_n(uint32_t *r, const size_t qn, const uint32_t *d, size_t m, const uint32_t inverse) {
+        m = std::min(m, qn);  //  разряды d выше qn на младшие qn разрядов произведения не влияют
+        if (qn < DIVEXACT_DC_THRESHOLD) {
+            for (size_t i = 0; i < qn; ++i) {
+                const uint32_t q = r[i] * inverse;
+                const size_t len = std::min(m, qn - i);
+                const uint32_t borrow = submul_1(d, len, q, r + i);  //  r[i] обнуляется, на его место - разряд частного
+                if (borrow != 0 && i + len < qn) {
+                    sub_from(r + i + len, qn - i - len, &borrow, 1);
+                }
+                r[i] = q;
+            }
+            return;
+        }
+        const size_t h = qn / 2;
+        divexact_n(r, h, d, m, inverse);
+        scratch_scope scratch;
+        uint32_t *t = scratch.allocate(h + m);
+        mul(r, h, d, m, t);
+        sub_from(r + h, qn - h, t + h, std::min(qn - h, m));
+        divexact_n(r + h, qn - h, d, m, inverse);
+    }
+}
+
+static_assert(optimized_storage::MAX_STATIC_SIZE * sizeof(uint32_t) > sizeof(void *)
+              || sizeof(big_integer) == 2 * sizeof(void *), "big_integer must be two words with default static storage");
+
+big_integer::big_integer() : data(1, 0) {}
 
 big_integer::big_integer(const big_integer &other) = default;
 
 big_integer::big_integer(const int a) : data(1,
-        a == INT_MIN ? static_cast<uint32_t>(INT_MAX) + 1 : abs(a)), sign(a < 0) {}
+        a == INT_MIN ? static_cast<uint32_t>(INT_MAX) + 1 : abs(a)) {
+    set_sign(a < 0);
+}
+
+big_integer::big_integer(const uint32_t a) : data(1, a) {}
 
-big_integer::big_integer(const uint32_t a) : data(1, a), sign(false) {}
+big_integer::big_integer(const std::string &str) : big_integer(str, 10) {}
 
-big_integer::big_integer(const std::string &str) : big_integer() {
-    if (str.empty()) {
-        throw std::runtime_error("Expected: integer, found: empty string");
+big_integer::big_integer(const std::string &str, const uint32_t base) : big_integer() {
+    BIGINT_TRACE_SCOPE(FROM_STRING, str.size());
+    check_base(base);
+    const size_t start = !str.empty() && str[0] == '-';
+    if (str.size() == start) {
+        throw std::runtime_error("Expected: integer, found: " + (str.empty() ? std::string("empty string") : str));
+    }
+    const char *first = str.data() + start, *last = str.data() + str.size();
+    const radix_chunk chunk = chunk_of(base);
+    const size_t block = RADIX_DC_THRESHOLD * chunk.digits;
+    if (is_power_of_two(base) || static_cast<size_t>(last - first) <= block) {
+        assign_digits(first, last, base);
+    } else {
+        //  Разделяй и властвуй: блоки по RADIX_DC_THRESHOLD чанков переводятся схемой Горнера и склеиваются
+        std::vector<big_integer> values;
+        for (const char *end = last; end != first;) {
+            const char *begin = end - std::min(block, static_cast<size_t>(end - first));
+            values.emplace_back();
+            values.back().assign_digits(begin, end, base);
+            end = begin;
+        }
+        *this = join_blocks(values, pow(big_integer(chunk.base), RADIX_DC_THRESHOLD));
+    }
+    set_sign(start == 1);
+    shrink_to_fit();
+}
+
+big_integer big_integer::join_blocks(std::vector<big_integer> values, big_integer power) {
+    //  соседние значения попарно склеиваются как lo + hi * power, умножение Карацубы делает это субквадратичным
+    while (values.size() > 1) {
+        for (size_t i = 0; 2 * i < values.size(); ++i) {
+            if (2 * i + 1 < values.size()) {
+                values[i] = values[2 * i] + values[2 * i + 1] * power;
+            } else {
+                values[i] = values[2 * i];
+            }
+        }
+        values.resize((values.size() + 1) / 2);
+        if (values.size() > 1) {
+            power *= power;
+        }
+    }
+    return values.empty() ? big_integer() : values[0];
+}
+
+void big_integer::write_digits(const big_integer &a, const uint32_t base, std::string &str, std::ostream *out) {
+    check_base(base);
+    if (a.sign()) {
+        str += '-';
+    }
+    if (a.size() == 1 && a[0] == 0) {
+        str += '0';
+    } else if (is_power_of_two(base)) {  //  каждая цифра - свои digit_bits бит, линейно
+        const auto digit_bits = static_cast<size_t>(__builtin_ctz(base));
+        for (size_t i = (a.magnitude_bit_length() + digit_bits - 1) / digit_bits; i-- > 0;) {
+            const size_t bit = i * digit_bits;
+            const uint64_t window = a.get_kth(bit / 32) | (static_cast<uint64_t>(a.get_kth(bit / 32 + 1)) << 32u);
+            str += DIGITS[(window >> (bit % 32)) & (base - 1)];
+            if (out && str.size() == WRITE_BLOCK_SIZE) {
+                flush_digits(str, out);
+            }
+        }
+    } else {
+        //  Разделяй и властвуй: деление на powers[i] делит число на половины, которые переводятся независимо.
+        //  Частное считается по Барретту - умножением на обратное к powers[i], найденное итерациями Ньютона
+        //  один раз на уровень, - поэтому разбиение стоит O(M(n)) вместо квадратичного деления, а весь перевод
+        //  O(M(n) log n), а не O(n^2), как у последовательного деления на chunk.base
+        const radix_chunk chunk = chunk_of(base);
+        //  powers[i] = chunk.base^(RADIX_DC_THRESHOLD * 2^i); квадрат последней больше a, тогда и на каждом
+        //  уровне x < powers[k - 1]^2, частное и остаток меньше powers[k - 1], а листья - не длиннее порога
+        std::vector<big_integer> powers{pow(big_integer(chunk.base), RADIX_DC_THRESHOLD)};
+        while (2 * powers.back().size() - 2 < a.size()) {  //  квадрат числа из s разрядов не меньше BASE^(2s - 2)
+            powers.push_back(powers.back() * powers.back());
+        }
+        //  обратные общие для всех узлов уровня: частное x / powers[i] - старшие разряды x * inverses[i]
+        std::vector<big_integer> inverses;
+        for (const big_integer &p : powers) {
+            inverses.push_back(reciprocal(p));
+        }
+        big_integer x(a);
+        x.set_sign(false);
+        write_digits(x, powers, inverses, powers.size(), base, 0, str, out);
+    }
+    flush_digits(str, out);
+}
+
+void big_integer::write_digits(const big_integer &x, const std::vector<big_integer> &powers,
+                               const std::vector<big_integer> &inverses, const size_t k, const uint32_t base,
+                               const size_t min_digits, std::string &str, std::ostream *out) {
+    const radix_chunk chunk = chunk_of(base);
+    if (k == 0) {  //  деление на наибольшую степень основания, помещающуюся в разряд, дает сразу chunk.digits цифр
+        scratch_scope scratch;
+        size_t n = x.size();
+        uint32_t *r = scratch.allocate(n);
+        std::copy(x.data.data(), x.data.data() + n, r);
+        const size_t start = str.size();
+        const small_divisor divisor(chunk.base);
+        while (n > 0 && r[n - 1] == 0) {
+            --n;
+        }
+        while (n > 0) {
+            uint32_t rem = divisor.divide(r, n, r);
+            while (n > 0 && r[n - 1] == 0) {
+                --n;
+            }
+            for (size_t i = 0; i < chunk.digits && (n > 0 || rem != 0); ++i) {
+                str += DIGITS[rem % base];
+                rem /= base;
+            }
+        }
+        if (str.size() - start < min_digits) {
+            str.append(min_digits - (str.size() - start), '0');
+        }
+        std::reverse(str.begin() + start, str.end());
+        if (str.size() >= WRITE_BLOCK_SIZE) {
+            flush_digits(str, out);
+        }
+        return;
+    }
+    const big_integer &p = powers[k - 1];
+    const size_t p_digits = chunk.digits * RADIX_DC_THRESHOLD << (k - 1);
+    if (x < p) {
+        write_digits(x, powers, inverses, k - 1, base, min_digits, str, out);
+        return;
+    }
+    //  частное Барретта: x < BASE^(2s), поэтому оценка меньше x / p не больше, чем на 2
+    const auto s = static_cast<int>(p.size());
+    big_integer q = ((x >> (32 * (s - 1))) * inverses[k - 1]) >> (32 * (s + 1));
+    big_integer r = x - q * p;
+    while (r >= p) {
+        ++q;
+        r -= p;
+    }
+    write_digits(q, powers, inverses, k - 1, base, min_digits > p_digits ? min_digits - p_digits : 0, str, out);
+    write_digits(r, powers, inverses, k - 1, base, p_digits, str, out);
+}
+
+//  Ньютон: обратное к старшим h разрядам, сдвинутое на s - h разрядов, верно примерно в h - 1 старших разрядах,
+//  один шаг y + y * (BASE^(2s) - p * y) / BASE^(2s) удваивает их число, остаток ошибки исправляется поправками
+big_integer big_integer::reciprocal(const big_integer &p) {
+    const size_t s = p.size();
+    const big_integer power = big_integer(1) << static_cast<int>(64 * s);
+    if (s <= RECIPROCAL_THRESHOLD) {
+        return power / p;
+    }
+    const auto low = static_cast<int>(32 * (s - (s / 2 + 2)));
+    big_integer y = reciprocal(p >> low) << low;
+    big_integer e = power - p * y;
+    const bool negative = e.sign();
+    e.set_sign(false);
+    const big_integer t = (y * e) >> static_cast<int>(64 * s);
+    y = negative ? y - t : y + t;
+    e = power - p * y;
+    while (e.sign()) {
+        --y;
+        e += p;
+    }
+    while (e >= p) {
+        ++y;
+        e -= p;
     }
-    big_integer base = 1;
-    for (ptrdiff_t i = str.size() - 1; i >= 0 && str[i] != '-'; --i) {
-        if (!isdigit(str[i])) {
-            throw std::runtime_error("Expected: digit, found: " + std::string(1, str[i]));
+    return y;
+}
+
+void big_integer::assign_digits(const char *first, const char *last, const uint32_t base) {
+    const auto n_digits = static_cast<size_t>(last - first);
+    const auto digit_bits = static_cast<size_t>(32 - __builtin_clz(base - 1));  //  не меньше log2(base)
+    data.assign(n_digits * digit_bits / 32 + 2, 0);
+    uint32_t *r = data.data();
+    if (is_power_of_two(base)) {  //  цифры кладутся по своим битам, начиная с младшей
+        size_t bit = 0;
+        for (const char *p = last; p != first; bit += digit_bits) {
+            const uint64_t value = static_cast<uint64_t>(digit_value(*--p, base)) << (bit % 32);
+            r[bit / 32] |= low32_bits(value);
+            r[bit / 32 + 1] |= high32_bits(value);
+        }
+    } else {  //  схема Горнера по чанкам из нескольких цифр, помещающимся в разряд
+        const radix_chunk chunk = chunk_of(base);
+        size_t n = 1;
+        for (const char *p = first; p != last;) {
+            const auto rest = static_cast<size_t>(last - p);
+            const size_t len = rest % chunk.digits == 0 ? chunk.digits : rest % chunk.digits;  //  неполный - старший
+            uint32_t value = 0, multiplier = 1;
+            for (size_t i = 0; i < len; ++i, ++p) {
+                value = value * base + digit_value(*p, base);
+                multiplier *= base;
+            }
+            uint32_t carry = mul_1(r, n, multiplier, r);
+            if (carry) {
+                r[n++] = carry;
+            }
+            carry = add_to(r, n, &value, 1);
+            if (carry) {
+                r[n++] = carry;
+            }
         }
-        *this += base * static_cast<uint32_t>(str[i] - '0');
-        base *= 10;
     }
-    sign = (str[0] == '-');
     shrink_to_fit();
 }
 
 big_integer::~big_integer() = default;
 
+void big_integer::set_thread_count(const size_t n) {
+    pool.reset(n > 1 ? new thread_pool(n) : nullptr);
+}
+
+size_t big_integer::thread_count() {
+    return pool ? pool->size() : 1;
+}
+
+size_t big_integer::hash() const {
+    const size_t h = data.hash();
+    return sign() ? ~h : h;
+}
+
 big_integer &big_integer::operator=(const big_integer &other) = default;
 
+bool big_integer::sign() const {
+    return data.sign();
+}
+
+void big_integer::set_sign(const bool value) {
+    data.set_sign(value);
+}
+
+bool big_integer::to_int64(int64_t &value) const {
+    if (size() > 2) {
+        return false;
+    }
+    const uint64_t magnitude = (static_cast<uint64_t>(get_kth(1)) << 32u) | data[0];
+    if (magnitude > static_cast<uint64_t>(INT64_MAX) + sign()) {
+        return false;
+    }
+    value = sign() ? -static_cast<int64_t>(magnitude - 1) - 1 : static_cast<int64_t>(magnitude);
+    return true;
+}
+
+void big_integer::assign_int64(const int64_t value) {
+    const uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    if (high32_bits(magnitude) != 0) {
+        data.assign(2, high32_bits(magnitude));
+        data[0] = low32_bits(magnitude);
+    } else {
+        data.assign(1, low32_bits(magnitude));
+    }
+    set_sign(value < 0);
+}
+
+bool big_integer::int64_operation(const big_integer &rhs, bool (*op)(int64_t, int64_t, int64_t &)) {
+    int64_t x, y, r;
+    if (!to_int64(x) || !rhs.to_int64(y) || !op(x, y, r)) {
+        return false;
+    }
+    assign_int64(r);
+    return true;
+}
+
+big_integer big_integer::from_magnitude(const uint64_t magnitude, const bool negative) {
+    big_integer a(low32_bits(magnitude));
+    if (high32_bits(magnitude) != 0) {
+        a.data.push_back(high32_bits(magnitude));
+    }
+    a.set_sign(negative && magnitude != 0);
+    return a;
+}
+
+bool big_integer::primitive_to_int64(const uint64_t magnitude, const bool negative, int64_t &value) {
+    if (magnitude > static_cast<uint64_t>(INT64_MAX) + negative) {
+        return false;
+    }
+    value = negative && magnitude != 0 ? -static_cast<int64_t>(magnitude - 1) - 1 : static_cast<int64_t>(magnitude);
+    return true;
+}
+
+big_integer &big_integer::add_primitive(const uint64_t magnitude, const bool negative) {
+    BIGINT_TRACE_SCOPE(ADD, size());
+    int64_t x, y, r;
+    if (to_int64(x) && primitive_to_int64(magnitude, negative, y) && !__builtin_add_overflow(x, y, &r)) {
+        assign_int64(r);
+        return *this;
+    } else if (high32_bits(magnitude) != 0) {
+        return *this += from_magnitude(magnitude, negative);
+    }
+    const uint32_t b = low32_bits(magnitude);
+    if (sign() == negative) {
+        const uint32_t carry = add_to(data.data(), size(), &b, 1);
+        if (carry) {
+            data.push_back(carry);
+        }
+    } else if (size() > 1 || data[0] >= b) {
+        sub_from(data.data(), size(), &b, 1);
+        shrink_to_fit();
+    } else {
+        data[0] = b - data[0];
+        set_sign(negative);
+    }
+    return *this;
+}
+
+big_integer &big_integer::mul_primitive(const uint64_t magnitude, const bool negative) {
+    BIGINT_TRACE_SCOPE(MUL, size());
+    int64_t x, y, r;
+    if (to_int64(x) && primitive_to_int64(magnitude, negative, y) && !__builtin_mul_overflow(x, y, &r)) {
+        assign_int64(r);
+        return *this;
+    } else if (high32_bits(magnitude) != 0) {
+        return *this *= from_magnitude(magnitude, negative);
+    } else if (magnitude == 0) {
+        assign_int64(0);
+        return *this;
+    }
+    const uint32_t carry = mul_1(data.data(), size(), low32_bits(magnitude), data.data());
+    if (carry) {
+        data.push_back(carry);
+    }
+    set_sign(sign() ^ negative);
+    return *this;
+}
+
+big_integer &big_integer::div_primitive(const uint64_t magnitude, const bool negative) {
+    BIGINT_TRACE_SCOPE(DIV, size());
+    int64_t x, y;
+    if (magnitude == 0) {
+        throw std::runtime_error("Division by zero");
+    } else if (to_int64(x) && primitive_to_int64(magnitude, negative, y) && !(x == INT64_MIN && y == -1)) {
+        assign_int64(x / y);
+        return *this;
+    } else if (high32_bits(magnitude) != 0) {
+        return *this /= from_magnitude(magnitude, negative);
+    }
+    set_sign(sign() ^ negative);
+    return *this /= small_divisor(low32_bits(magnitude));
+}
+
+big_integer &big_integer::mod_primitive(const uint64_t magnitude, const bool negative) {
+    BIGINT_TRACE_SCOPE(MOD, size());
+    int64_t x, y;
+    if (magnitude == 0) {
+        throw std::runtime_error("Division by zero");
+    } else if (to_int64(x) && primitive_to_int64(magnitude, negative, y) && !(x == INT64_MIN && y == -1)) {
+        assign_int64(x % y);
+        return *this;
+    } else if (high32_bits(magnitude) != 0) {
+        return *this %= from_magnitude(magnitude, negative);
+    }
+    return *this %= small_divisor(low32_bits(magnitude));
+}
+
+big_integer &big_integer::operator/=(const small_divisor &rhs) {
+    BIGINT_TRACE_SCOPE(DIV, size());
+    rhs.divide(data.data(), size(), data.data());
+    shrink_to_fit();
+    return *this;
+}
+
+big_integer &big_integer::operator%=(const small_divisor &rhs) {
+    BIGINT_TRACE_SCOPE(MOD, size());
+    const big_integer &self = *this;  //  константный доступ не копирует разделяемый буфер
+    const uint32_t rem = rhs.remainder(self.data.data(), size());
+    const bool negative_rem = sign() && rem != 0;  //  знак остатка совпадает со знаком делимого
+    data.assign(1, rem);
+    set_sign(negative_rem);
+    return *this;
+}
+
 size_t big_integer::size() const {
     return data.size();
 }
@@ -70,9 +792,13 @@ uint32_t big_integer::high32_bits(const uint64_t a) {
 }
 
 big_integer &big_integer::operator+=(const big_integer &rhs) {
-    if (sign && !rhs.sign) {
+    BIGINT_TRACE_SCOPE(ADD, std::max(size(), rhs.size()));
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) { return !__builtin_add_overflow(x, y, &r); })) {
+        return *this;
+    }
+    if (sign() && !rhs.sign()) {
         return *this = rhs - (-*this);
-    } else if (!sign && rhs.sign) {
+    } else if (!sign() && rhs.sign()) {
         return *this -= -rhs;
     }  //  свел задачу к a + b, где a и b одного знака
     bool carry = false;
@@ -91,11 +817,15 @@ big_integer &big_integer::operator+=(const big_integer &rhs) {
 }
 
 big_integer &big_integer::operator-=(const big_integer &rhs) {
-    if (sign && !rhs.sign) {
+    BIGINT_TRACE_SCOPE(SUB, std::max(size(), rhs.size()));
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) { return !__builtin_sub_overflow(x, y, &r); })) {
+        return *this;
+    }
+    if (sign() && !rhs.sign()) {
         return *this = -(rhs - *this);
-    } else if (!sign && rhs.sign) {
+    } else if (!sign() && rhs.sign()) {
         return *this += -rhs;
-    } else if (sign && rhs.sign) {
+    } else if (sign() && rhs.sign()) {
         return *this = -((-*this) -= (-rhs));
     } else if (*this < rhs) {
         return *this = -(rhs - *this);
@@ -115,13 +845,16 @@ size_t big_integer::bit_count(const uint32_t a) {
 }
 
 //  На степень двойки делить и умножать можно с помощью сдвигов.
-//  Эти тесты не ускоряются, но для очень больших чисел оптимизация полезна
-uint32_t big_integer::count() const {
-    uint32_t ans = 0;
-    for (size_t i = 0; i < data.size(); ++i) {
-        ans += bit_count(data[i]);
+//  Модуль - степень двойки; у случайного числа проверка заканчивается на младшем разряде
+bool big_integer::has_single_bit() const {
+    const uint32_t *d = data.data();
+    const size_t n = data.size();
+    for (size_t i = 0; i + 1 < n; ++i) {
+        if (d[i] != 0) {
+            return false;
+        }
     }
-    return ans;
+    return bit_count(d[n - 1]) == 1;
 }
 
 ///  pre: *this is the power of 2
@@ -136,145 +869,239 @@ uint32_t big_integer::clear_log2() const {
     throw std::runtime_error("pre-condition is not followed");
 }
 
-big_integer &big_integer::operator*=(const big_integer &rhs) {
-    if (!sign && count() == 1) {
-        return *this = rhs << clear_log2();
-    } else if (!rhs.sign && rhs.count() == 1) {
-        return *this <<= rhs.clear_log2();
+size_t big_integer::magnitude_bit_length() const {
+    const uint32_t top = data.back();
+    return top == 0 ? 0 : (size() - 1) * 32 + (32 - __builtin_clz(top));
+}
+
+//  -m = ~(m - 1), поэтому у отрицательных все считается по m - 1: длина меньше на 1 у степеней двойки,
+//  а m - 1 отличается от m только до младшей единицы включительно
+size_t big_integer::bit_length() const {
+    const size_t bits = magnitude_bit_length();
+    return sign() && has_single_bit() ? bits - 1 : bits;
+}
+
+bool big_integer::test_bit(const size_t k) const {
+    const uint32_t *d = data.data();
+    const size_t i = k / 32;
+    if (i >= size()) {
+        return sign();
+    } else if (!sign()) {
+        return (d[i] >> (k % 32)) & 1u;
     }
-    big_integer ans;
-    ans.sign = sign ^ rhs.sign;
-    ans.fill_back(size() + rhs.size(), 0);
-    for (size_t i = 0; i < size(); ++i) {
-        uint32_t carry = 0;
-        for (size_t j = 0; j < rhs.size() || carry; ++j) {
-            const auto additive = static_cast<uint64_t>(data[i]) * rhs.get_kth(j) + carry + ans[i + j];
-            ans[i + j] = low32_bits(additive);
-            carry = high32_bits(additive);
-        }
+    size_t j = 0;
+    while (j < i && d[j] == 0) {
+        ++j;
     }
-    ans.shrink_to_fit();
-    return *this = ans;
+    const uint32_t limb = j < i ? ~d[i] : 0 - d[i];  //  разряд i числа -m: ниже него единица уже встретилась или нет
+    return (limb >> (k % 32)) & 1u;
 }
 
-std::pair<big_integer, uint32_t> big_integer::short_div(const big_integer &a, const uint32_t b) {
-    if (b == 0) {
-        throw std::runtime_error("Division by zero");
+//  смена бита с 0 на 1 прибавляет 2^k, с 1 на 0 - вычитает, поэтому у отрицательных меняется модуль на 2^k
+big_integer &big_integer::set_bit(const size_t k, const bool value) {
+    BIGINT_TRACE_SCOPE(BITWISE, size());
+    if (test_bit(k) == value) {
+        return *this;
     }
-    uint64_t carry = 0;
-    big_integer ans(a);
-    for (ptrdiff_t i = ans.size() - 1; i >= 0; --i) {
-        const auto dividend = static_cast<uint64_t>(ans[i]) + carry * BASE;
-        ans[i] = low32_bits(dividend / b);
-        carry = dividend % b;
+    const size_t i = k / 32;
+    const uint32_t bit = 1u << (k % 32);
+    if (i >= size()) {  //  у отрицательных такие биты единичные, поэтому здесь value != sign() и разряды нужны
+        fill_back(i + 1 - size(), 0);
     }
-    ans.shrink_to_fit();
-    return {ans, carry};
+    if (!sign()) {
+        data[i] ^= bit;
+        shrink_to_fit();
+    } else if (value) {  //  x + 2^k = -(m - 2^k), m > 2^k, так как бит k числа x был нулевым
+        sub_from(data.data() + i, size() - i, &bit, 1);
+        shrink_to_fit();
+    } else if (add_to(data.data() + i, size() - i, &bit, 1)) {  //  x - 2^k = -(m + 2^k)
+        data.push_back(1);
+    }
+    return *this;
 }
 
-uint32_t big_integer::trial(const uint64_t k, const uint64_t m, const big_integer &d) const {
-    const auto r3 = (static_cast<uint128_t>(data[k + m]) * BASE + data[k + m - 1]) * BASE + data[k + m - 2];
-    const uint64_t d2 = (static_cast<uint64_t>(d[m - 1]) << 32u) + d[m - 2];
-    return low32_bits(std::min(r3 / d2, static_cast<uint128_t>(BASE - 1)));
+size_t big_integer::popcount() const {
+    const uint32_t *d = data.data();
+    const size_t n = size();
+    size_t i = 0, ans = 0;
+    if (sign()) {  //  m - 1: нули младше первой единицы становятся единицами, она сама - нулем
+        while (d[i] == 0) {
+            ++i;
+        }
+        ans = 32 * i + bit_count(d[i] - 1);
+        ++i;
+    }
+    for (; i < n; ++i) {
+        ans += bit_count(d[i]);
+    }
+    return ans;
 }
 
-bool big_integer::smaller(const big_integer &dq, const uint64_t k, const uint64_t m) const {
-    uint64_t i = m, j = 0;
-    while (i != j) {
-        data[i + k] == dq[i] ? --i : j = i;
+size_t big_integer::trailing_zeros() const {
+    const uint32_t *d = data.data();
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        if (d[i] != 0) {
+            return 32 * i + __builtin_ctz(d[i]);
+        }
     }
-    return data[i + k] < dq[i];
+    return 0;
 }
 
-void big_integer::difference(const big_integer &dq, const uint64_t k, const uint64_t m) {
-    uint64_t borrow = 0;
-    for (size_t i = 0; i <= m; ++i) {
-        const uint64_t diff = static_cast<uint64_t>(data[i + k]) - dq[i] - borrow + BASE;  //  i = dq.size() - беда
-        data[i + k] = low32_bits(diff);
-        borrow = 1 - high32_bits(diff);
+big_integer &big_integer::operator*=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(MUL, std::max(size(), rhs.size()));
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) { return !__builtin_mul_overflow(x, y, &r); })) {
+        return *this;
     }
+    if (!sign() && has_single_bit()) {
+        return *this = rhs << clear_log2();
+    } else if (!rhs.sign() && rhs.has_single_bit()) {
+        return *this <<= rhs.clear_log2();
+    }
+    big_integer ans;
+    multiply(*this, rhs, ans);
+    swap(ans);
+    return *this;
+}
+
+void big_integer::multiply(const big_integer &a, const big_integer &b, big_integer &ans) {
+    ans.data.assign(a.size() + b.size(), 0);
+    ans.set_sign(a.sign() ^ b.sign());
+    mul(a.data.data(), a.size(), b.data.data(), b.size(), ans.data.data());
+    ans.shrink_to_fit();
 }
 
 big_integer &big_integer::operator/=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(DIV, std::max(size(), rhs.size()));
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) {
+        return y != 0 && !(x == INT64_MIN && y == -1) && (r = x / y, true);
+    })) {
+        return *this;
+    }
     if (size() < rhs.size()) {
         return *this = 0;
     } else if (rhs.size() == 1) {
-        const auto ans = big_integer::short_div(*this, rhs[0]);
-        return *this = rhs.sign ? -ans.first : ans.first;
-    } else if (!rhs.sign && rhs.count() == 1) {
+        return div_primitive(rhs[0], rhs.sign());
+    } else if (!sign() && !rhs.sign() && rhs.has_single_bit()) {
         return *this >>= rhs.clear_log2();
     }
+    //  Алгоритм D: цифра частного оценивается по старшим разрядам нормализованных делимого и делителя,
+    //  сдвинутые разряды считаются на лету, поэтому делитель читается на месте и не копируется,
+    //  например, из отображенного в память big_integer_view; остаток и произведения - в арене потока
+    scratch_scope scratch;
+    const big_integer &self = *this;
     const size_t n = size(), m = rhs.size();
-    const uint64_t f = BASE / (static_cast<uint64_t>(rhs[m - 1]) + 1);
-    big_integer q, r = (*this) * f, d = rhs * f;
-    q.sign = sign ^ rhs.sign;
-    q.fill_back(n - m + 1, 0);
-    r.sign = d.sign = false;
-    r.fill_back(1, 0);
+    const uint32_t *d = rhs.data.data();
+    const auto shift = static_cast<uint32_t>(__builtin_clz(d[m - 1]));
+    uint32_t *r = scratch.allocate(n + 1), *dq = scratch.allocate(m + 1);
+    std::copy(self.data.data(), self.data.data() + n, r);
+    r[n] = 0;
+    const auto shifted = [shift](const uint32_t *x, const ptrdiff_t j) {  //  разряд j числа x << shift
+        const uint64_t window = (static_cast<uint64_t>(x[j]) << 32u) | (j > 0 ? x[j - 1] : 0);
+        return static_cast<uint32_t>(window >> (32 - shift));
+    };
+    big_integer q;
+    q.data.assign(n - m + 1, 0);
+    q.set_sign(sign() ^ rhs.sign());
+    uint32_t *qd = q.data.data();
+    const uint64_t d2 = (static_cast<uint64_t>(shifted(d, m - 1)) << 32u) + shifted(d, m - 2);
     for (ptrdiff_t k = n - m; k >= 0; --k) {
-        uint32_t qt = r.trial(static_cast<uint64_t>(k), m, d);
-        auto dq = big_integer(qt) * d;
-        dq.fill_back(m + 1, 0);
-        if (r.smaller(dq, static_cast<uint64_t>(k), m)) {
-            qt--;
-            dq = d * qt;
+        const ptrdiff_t top = k + m;
+        const auto r3 = (static_cast<uint128_t>(shifted(r, top)) * BASE + shifted(r, top - 1)) * BASE
+                        + shifted(r, top - 2);
+        auto qt = low32_bits(std::min(r3 / d2, static_cast<uint128_t>(BASE - 1)));
+        dq[m] = mul_1(d, m, qt, dq);
+        if (compare_n(r + k, dq, m + 1) < 0) {  //  оценка по трем разрядам ошибается не больше, чем на 1
+            --qt;
+            sub_from(dq, m + 1, d, m);
         }
-        q[k] = qt;
-        r.difference(dq, static_cast<uint64_t>(k), m);
+        sub_from(r + k, m + 1, dq, m + 1);
+        qd[k] = qt;
     }
     q.shrink_to_fit();
-    return *this = q;
+    swap(q);
+    return *this;
 }
 
 big_integer &big_integer::operator%=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(MOD, std::max(size(), rhs.size()));
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) {
+        return y != 0 && !(x == INT64_MIN && y == -1) && (r = x % y, true);
+    })) {
+        return *this;
+    } else if (rhs.size() == 1) {
+        return mod_primitive(rhs[0], rhs.sign());
+    }
     return *this -= (*this / rhs) * rhs;
 }
 
 void big_integer::to_additional_code(const size_t n_digits) {
     fill_back(n_digits - size(), 0);
-    if (sign) {
-        sign = false;
-        for (size_t i = 0; i < data.size(); ++i) {
-            data[i] = ~data[i];
+    if (sign()) {
+        set_sign(false);
+        uint32_t *d = data.data();
+        for (size_t i = 0; i < n_digits; ++i) {
+            d[i] = ~d[i];
+        }
+        //  +1 переносом по разрядам, а не через += 1: быстрый путь int64 укоротил бы буфер до значащих разрядов;
+        //  перенос наружу возможен только для результата -2^(32 * n_digits), ему нужен лишний разряд
+        const uint32_t one = 1;
+        if (add_to(d, n_digits, &one, 1)) {
+            data.push_back(1);
         }
-        *this += 1;
     }
 }
 
 big_integer &
 big_integer::bitwise_operation(const big_integer &rhs, const func &f) {
+    BIGINT_TRACE_SCOPE(BITWISE, std::max(size(), rhs.size()));
     big_integer ans(*this), tmp_rhs(rhs);
     const size_t max_size = std::max(size(), rhs.size());
     ans.to_additional_code(max_size);
     tmp_rhs.to_additional_code(max_size);
-    ans.sign = f(sign, rhs.sign);
+    ans.set_sign(f(sign(), rhs.sign()));
     for (size_t i = 0; i < max_size; ++i) {
         ans[i] = f(ans[i], tmp_rhs[i]);
     }
-    if (ans.sign) {
+    if (ans.sign()) {
         ans.to_additional_code(max_size);
-        ans.sign = true;
+        ans.set_sign(true);
     }
     ans.shrink_to_fit();
     return *this = ans;
 }
 
 big_integer &big_integer::operator&=(const big_integer &rhs) {
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) { return r = x & y, true; })) {
+        return *this;
+    }
     return *this = bitwise_operation(rhs, [](uint32_t a, uint32_t b) { return a & b; });
 }
 
 big_integer &big_integer::operator|=(const big_integer &rhs) {
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) { return r = x | y, true; })) {
+        return *this;
+    }
     return *this = bitwise_operation(rhs, [](uint32_t a, uint32_t b) { return a | b; });
 }
 
 big_integer &big_integer::operator^=(const big_integer &rhs) {
+    if (int64_operation(rhs, [](int64_t x, int64_t y, int64_t &r) { return r = x ^ y, true; })) {
+        return *this;
+    }
     return *this = bitwise_operation(rhs, [](uint32_t a, uint32_t b) { return a ^ b; });
 }
 
 big_integer &big_integer::operator<<=(const int b) {
+    BIGINT_TRACE_SCOPE(SHIFT, size());
     if (b < 0) {
         return *this >>= (-b);
     }
+    int64_t x;
+    if (b < 63 && to_int64(x) && x >= (INT64_MIN >> b) && x <= (INT64_MAX >> b)) {
+        assign_int64(x * (static_cast<int64_t>(1) << b));
+        return *this;
+    }
     const auto n_added = static_cast<size_t>(b / 32);
     fill_back(n_added, 0);
     for (ptrdiff_t i = size() - n_added - 1; i >= 0; --i) {
@@ -293,25 +1120,42 @@ big_integer &big_integer::operator<<=(const int b) {
 }
 
 big_integer &big_integer::operator>>=(const int b) {
+    BIGINT_TRACE_SCOPE(SHIFT, size());
     if (b < 0) {
         return *this <<= (-b);
     }
-    const auto n_deleted = static_cast<size_t>(b / 32);
-    for (size_t i = 0; i < size() - n_deleted; ++i) {
-        data[i] = data[i + n_deleted];
-    }
-    for (size_t i = 0; i < n_deleted; ++i) {
-        data.pop_back();
+    int64_t x;
+    if (to_int64(x)) {
+        assign_int64(b >= 63 ? (x < 0 ? -1 : 0) : x >> b);
+        return *this;
     }
+    const auto n_deleted = static_cast<size_t>(b / 32);
     const auto shift = static_cast<uint32_t>(b % 32);
-    uint32_t carry = 0;
-    for (ptrdiff_t i = size() - 1; i >= 0; --i) {
-        const auto tmp = static_cast<uint64_t>(data[i]) << (32 - shift);
-        data[i] = high32_bits(tmp) | carry;
-        carry = low32_bits(tmp);
+    const bool negative = sign();
+    bool lost = false;  //  отрицательные числа округляются вниз, если отброшены ненулевые биты
+    if (n_deleted >= size()) {
+        lost = true;
+        *this = 0;
+    } else {
+        for (size_t i = 0; i < n_deleted; ++i) {
+            lost |= get_kth(i) != 0;
+        }
+        lost |= (get_kth(n_deleted) & ((1u << shift) - 1)) != 0;
+        for (size_t i = 0; i < size() - n_deleted; ++i) {
+            data[i] = data[i + n_deleted];
+        }
+        for (size_t i = 0; i < n_deleted; ++i) {
+            data.pop_back();
+        }
+        uint32_t carry = 0;
+        for (ptrdiff_t i = size() - 1; i >= 0; --i) {
+            const auto tmp = static_cast<uint64_t>(data[i]) << (32 - shift);
+            data[i] = high32_bits(tmp) | carry;
+            carry = low32_bits(tmp);
+        }
+        shrink_to_fit();
     }
-    shrink_to_fit();
-    return sign ? --(*this) : (*this);
+    return negative && lost ? --(*this) : (*this);
 }
 
 big_integer big_integer::operator+() const {
@@ -321,7 +1165,7 @@ big_integer big_integer::operator+() const {
 big_integer big_integer::operator-() const {
     big_integer a(*this);
     if (a != 0) {
-        a.sign ^= true;
+        a.set_sign(!a.sign());
     }
     return a;
 }
@@ -370,6 +1214,14 @@ big_integer operator%(big_integer a, const big_integer &b) {
     return a %= b;
 }
 
+big_integer operator/(big_integer a, const small_divisor &b) {
+    return a /= b;
+}
+
+big_integer operator%(big_integer a, const small_divisor &b) {
+    return a %= b;
+}
+
 big_integer operator&(big_integer a, const big_integer &b) {
     return a &= b;
 }
@@ -390,69 +1242,364 @@ big_integer operator>>(big_integer a, const int b) {
     return a >>= b;
 }
 
+int compare(const big_integer &a, const big_integer &b) {
+    int64_t x, y;
+    if (a.to_int64(x) && b.to_int64(y)) {
+        return (x > y) - (x < y);
+    }
+    if (a.sign() != b.sign()) {
+        return a.sign() ? -1 : 1;
+    }
+    int result;  //  сравнение модулей: сначала по длине, затем поразрядно со старшего разряда
+    if (a.size() != b.size()) {
+        result = a.size() < b.size() ? -1 : 1;
+    } else {
+        result = compare_n(a.data.data(), b.data.data(), a.size());
+    }
+    return a.sign() ? -result : result;
+}
+
 bool operator==(const big_integer &a, const big_integer &b) {
-    return (a.sign == b.sign && a.data == b.data);
+    return compare(a, b) == 0;
 }
 
 bool operator!=(const big_integer &a, const big_integer &b) {
-    return !(a == b);
+    return compare(a, b) != 0;
 }
 
 bool operator<(const big_integer &a, const big_integer &b) {
-    if (a.sign != b.sign) {
-        return a.sign;
-    }
-    if (a.size() != b.size()) {
-        return (a.size() < b.size()) ^ a.sign;
-    }
-    for (ptrdiff_t i = a.size() - 1; i >= 0; --i) {
-        if (a[i] != b[i]) {
-            return (a[i] < b[i]) ^ a.sign;
-        }
-    }
-    return false;
+    return compare(a, b) < 0;
 }
 
 bool operator>(const big_integer &a, const big_integer &b) {
-    return !(a <= b);
+    return compare(a, b) > 0;
 }
 
 bool operator<=(const big_integer &a, const big_integer &b) {
-    return (a < b) || (a == b);
+    return compare(a, b) <= 0;
 }
 
 bool operator>=(const big_integer &a, const big_integer &b) {
-    return !(a < b);
+    return compare(a, b) >= 0;
 }
 
 std::string to_string(const big_integer &a) {
-    if (a == 0) {
-        return "0";
-    }
+    return to_string(a, 10);
+}
+
+std::string to_string(const big_integer &a, const uint32_t base) {
+    BIGINT_TRACE_SCOPE(TO_STRING, a.size());
     std::string str;
-    big_integer tmp(a);
-    while (tmp != 0) {
-        const auto division = big_integer::short_div(tmp, 10);
-        str += static_cast<char>('0' + division.second);
-        tmp = division.first;
+    big_integer::write_digits(a, base, str, nullptr);
+    return str;
+}
+
+//  Бинарное возведение в степень слева направо: один буфер под результат и один под
+//  промежуточное произведение, оба сразу выделяются под итоговую длину.
+big_integer pow(const big_integer &a, const uint32_t n) {
+    if (n == 0) {
+        return 1;
+    } else if (a.has_single_bit()) {
+        const uint64_t shift = static_cast<uint64_t>(a.clear_log2()) * n;
+        if (shift > INT_MAX) {
+            throw std::runtime_error("Power of two is too large");
+        }
+        big_integer ans = big_integer(1) << static_cast<int>(shift);
+        ans.set_sign(a.sign() && (n % 2 == 1));
+        return ans;
     }
-    if (a.sign) {
-        str += '-';
+    const size_t limbs = (static_cast<uint64_t>(a.magnitude_bit_length()) * n + 31) / 32 + 1;
+    big_integer ans = 1, tmp;
+    ans.data.reserve(limbs);
+    tmp.data.reserve(limbs);
+    for (int bit = 31 - __builtin_clz(n); bit >= 0; --bit) {
+        big_integer::multiply(ans, ans, tmp);
+        ans.swap(tmp);
+        if ((n >> static_cast<uint32_t>(bit)) & 1u) {
+            big_integer::multiply(ans, a, tmp);
+            ans.swap(tmp);
+        }
     }
-    reverse(str.begin(), str.end());
-    return str;
+    return ans;
+}
+
+//  На каждом уровне дерева числа сортируются по длине и перемножаются соседними парами,
+//  так что множители почти равны по размеру. Пары одного уровня независимы и при наличии
+//  пула считаются параллельно, каждая задача берет пары с шагом в число задач.
+big_integer product(std::vector<big_integer> values) {
+    if (values.empty()) {
+        return 1;
+    }
+    while (values.size() > 1) {
+        std::sort(values.begin(), values.end(), [](const big_integer &a, const big_integer &b) {
+            return a.size() < b.size();
+        });
+        const size_t pairs = values.size() / 2;
+        std::vector<big_integer> next(pairs + values.size() % 2);
+        if (values.size() % 2 == 1) {
+            next.back() = values.back();
+        }
+        const size_t n_tasks = pool ? std::min(pairs, 4 * pool->size()) : 1;
+        std::vector<thread_pool::task> tasks;
+        for (size_t t = 0; t < n_tasks; ++t) {
+            tasks.emplace_back([&values, &next, pairs, n_tasks, t] {
+                for (size_t i = t; i < pairs; i += n_tasks) {
+                    big_integer::multiply(values[2 * i], values[2 * i + 1], next[i]);
+                }
+            });
+        }
+        if (n_tasks > 1) {
+            pool->run(tasks);
+        } else {
+            tasks[0]();
+        }
+        values.swap(next);
+    }
+    return values[0];
+}
+
+big_integer isqrt(const big_integer &a) {
+    return iroot(a, 2);
+}
+
+//  Метод Ньютона x' = ((k - 1) * x + a / x^(k - 1)) / k строго убывает, пока x > floor(a^(1/k)).
+//  Начальное приближение сверху берется из корня старшей половины бит числа, поэтому
+//  точность удваивается с каждым уровнем рекурсии и на верхнем уровне хватает пары итераций.
+big_integer iroot(const big_integer &a, const uint32_t k) {
+    if (k == 0) {
+        throw std::runtime_error("Root of degree 0 is undefined");
+    } else if (a.sign()) {
+        if (k % 2 == 0) {
+            throw std::runtime_error("Root of even degree from negative number");
+        }
+        return -iroot(-a, k);
+    }
+    const size_t bits = a.magnitude_bit_length();
+    if (k == 1 || bits <= 1) {
+        return a;
+    } else if (bits <= k) {
+        return 1;
+    }
+    const size_t s = bits / (2 * k);
+    big_integer x = (s == 0)
+            ? big_integer(1) << static_cast<int>((bits + k - 1) / k)
+            : (iroot(a >> static_cast<int>(k * s), k) + 1) << static_cast<int>(s);
+    const big_integer k_big(k), k_minus_1(k - 1);
+    while (true) {
+        big_integer y = (x * k_minus_1 + a / pow(x, k - 1)) / k_big;
+        if (y >= x) {
+            return x;
+        }
+        x = y;
+    }
+}
+
+//  Деление Хензеля: разряды частного находятся с младшего, q_i = r_i * d_0^-1 mod B, без пробных
+//  частных и коррекций. Разряды остатка выше qn на частное не влияют и не вычисляются.
+//  Для длинных частных - разделяй и властвуй через mul, см. divexact_n
+big_integer divexact(const big_integer &a, const big_integer &b) {
+    BIGINT_TRACE_SCOPE(DIV, std::max(a.size(), b.size()));
+    if (b == 0) {
+        throw std::runtime_error("Division by zero");
+    } else if (a.size() < b.size() || a == 0) {
+        return 0;
+    }
+    //  делитель делается нечетным: k нулевых разрядов пропускаются, остальное сдвигается на shift бит,
+    //  у делимого те же младшие нули
+    const uint32_t *ad = a.data.data(), *bd = b.data.data();
+    size_t k = 0;
+    while (bd[k] == 0) {
+        ++k;
+    }
+    const auto shift = static_cast<uint32_t>(__builtin_ctz(bd[k]));
+    scratch_scope scratch;
+    size_t m = b.size() - k;
+    const uint32_t *d = bd + k;
+    if (shift != 0) {
+        uint32_t *t = scratch.allocate(m);
+        shift_right(bd + k, m, shift, 0, t);
+        m -= m > 1 && t[m - 1] == 0;
+        d = t;
+    }
+    const size_t n = a.size() - k - (a.size() - k > 1 && (ad[a.size() - 1] >> shift) == 0);
+    if (n < m) {
+        return 0;
+    }
+    const size_t qn = n - m + 1;
+    big_integer q;
+    q.data.assign(qn, 0);
+    uint32_t *r = q.data.data();
+    shift_right(ad + k, qn, shift, k + qn < a.size() ? ad[k + qn] : 0, r);
+    divexact_n(r, qn, d, m, inverse_limb(d[0]));
+    q.set_sign(a.sign() ^ b.sign());
+    q.shrink_to_fit();
+    return q;
 }
 
 std::ostream &operator<<(std::ostream &s, const big_integer &a) {
-    s << to_string(a);
+    if (s.width() != 0) {  //  выравнивание требует длины, тут без строки целиком не обойтись
+        return s << to_string(a, stream_base(s));
+    }
+    std::ostream::sentry sentry(s);
+    if (sentry) {
+        std::string block;
+        block.reserve(WRITE_BLOCK_SIZE + RADIX_DC_THRESHOLD * chunk_of(stream_base(s)).digits);
+        big_integer::write_digits(a, stream_base(s), block, &s);
+    }
     return s;
 }
 
+std::istream &operator>>(std::istream &s, big_integer &a) {
+    std::istream::sentry sentry(s);  //  пропускает пробельные символы
+    if (!sentry) {
+        return s;
+    }
+    const uint32_t base = stream_base(s);
+    std::streambuf *buf = s.rdbuf();
+    int c = buf->sgetc();
+    const bool negative = c == '-';
+    if (c == '-' || c == '+') {
+        c = buf->snextc();
+        if (c == std::char_traits<char>::eof() || any_digit_value(static_cast<char>(c)) >= base) {
+            buf->sungetc();  //  знак без цифры не извлекается, поток остается на нем
+            s.setstate(c == std::char_traits<char>::eof() ? std::ios_base::failbit | std::ios_base::eofbit
+                                                          : std::ios_base::failbit);
+            return s;
+        }
+    }
+    //  цифры читаются прямо из буфера потока чанками, чанки по RADIX_DC_THRESHOLD штук - в блоки схемой Горнера
+    const radix_chunk chunk = chunk_of(base);
+    std::vector<big_integer> blocks(1);
+    size_t n_digits = 0, n_chunks = 0, chunk_digits = 0;
+    uint32_t value = 0, multiplier = 1;
+    for (; c != std::char_traits<char>::eof(); c = buf->snextc(), ++n_digits) {
+        const uint32_t digit = any_digit_value(static_cast<char>(c));
+        if (digit >= base) {
+            break;
+        }
+        value = value * base + digit;
+        multiplier *= base;
+        if (++chunk_digits == chunk.digits) {
+            if (n_chunks == RADIX_DC_THRESHOLD) {
+                blocks.emplace_back();
+                n_chunks = 0;
+            }
+            (blocks.back() *= multiplier) += value;
+            ++n_chunks;
+            value = 0;
+            multiplier = 1;
+            chunk_digits = 0;
+        }
+    }
+    if (c == std::char_traits<char>::eof()) {
+        s.setstate(std::ios_base::eofbit);
+    }
+    if (n_digits == 0) {
+        s.setstate(std::ios_base::failbit);
+        return s;
+    }
+    //  блоки идут от старшего к младшему, все, кроме последнего, полные
+    if (blocks.size() == 1) {
+        a = blocks[0];
+    } else {
+        const big_integer last = blocks.back();
+        blocks.pop_back();
+        std::reverse(blocks.begin(), blocks.end());
+        a = big_integer::join_blocks(blocks, pow(big_integer(chunk.base), RADIX_DC_THRESHOLD));
+        (a *= pow(big_integer(chunk.base), static_cast<uint32_t>(n_chunks))) += last;
+    }
+    (a *= multiplier) += value;
+    if (negative) {
+        a = -a;
+    }
+    return s;
+}
+
+size_t serialized_size(const big_integer &a) {
+    return SERIALIZED_HEADER_SIZE + a.size() * sizeof(uint32_t);
+}
+
+void serialize(const big_integer &a, void *buffer) {
+    auto *p = static_cast<uint8_t *>(buffer);
+    store_le(p, (static_cast<uint64_t>(a.size()) << 1u) | a.sign(), SERIALIZED_HEADER_SIZE);
+    p += SERIALIZED_HEADER_SIZE;
+    const uint32_t *limbs = a.data.data();
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::copy(limbs, limbs + a.size(), reinterpret_cast<uint32_t *>(p));
+#else
+    for (size_t i = 0; i < a.size(); ++i) {
+        store_le(p + i * sizeof(uint32_t), limbs[i], sizeof(uint32_t));
+    }
+#endif
+}
+
+std::vector<uint8_t> serialize(const big_integer &a) {
+    std::vector<uint8_t> buffer(serialized_size(a));
+    serialize(a, buffer.data());
+    return buffer;
+}
+
+void serialize(const big_integer &a, std::ostream &out) {
+    uint8_t header[SERIALIZED_HEADER_SIZE];
+    store_le(header, (static_cast<uint64_t>(a.size()) << 1u) | a.sign(), SERIALIZED_HEADER_SIZE);
+    out.write(reinterpret_cast<const char *>(header), SERIALIZED_HEADER_SIZE);
+    const uint32_t *limbs = a.data.data();
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    out.write(reinterpret_cast<const char *>(limbs), static_cast<std::streamsize>(a.size() * sizeof(uint32_t)));
+#else
+    uint8_t block[1024];
+    for (size_t i = 0; i < a.size();) {
+        size_t bytes = 0;
+        for (; i < a.size() && bytes < sizeof(block); ++i, bytes += sizeof(uint32_t)) {
+            store_le(block + bytes, limbs[i], sizeof(uint32_t));
+        }
+        out.write(reinterpret_cast<const char *>(block), static_cast<std::streamsize>(bytes));
+    }
+#endif
+}
+
+big_integer deserialize(const void *buffer, const size_t bytes) {
+    const auto *p = static_cast<const uint8_t *>(buffer);
+    bool negative;
+    const size_t n = parse_header(p, bytes, negative);
+    p += SERIALIZED_HEADER_SIZE;
+    big_integer a;
+    a.data.assign(n, 0);
+    uint32_t *limbs = a.data.data();
+    for (size_t i = 0; i < n; ++i) {
+        limbs[i] = static_cast<uint32_t>(load_le(p + i * sizeof(uint32_t), sizeof(uint32_t)));
+    }
+    a.set_sign(negative);
+    return a;
+}
+
+big_integer deserialize_view(const void *buffer, const size_t bytes) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const auto *p = static_cast<const uint8_t *>(buffer);
+    bool negative;
+    const size_t n = parse_header(p, bytes, negative);
+    p += SERIALIZED_HEADER_SIZE;
+    if (reinterpret_cast<uintptr_t>(p) % alignof(uint32_t) != 0) {
+        throw std::runtime_error("Unaligned buffer of serialized big_integer");
+    }
+    big_integer a;
+    a.data.adopt(reinterpret_cast<const uint32_t *>(p), n);
+    a.set_sign(negative);
+    return a;
+#else
+    return deserialize(buffer, bytes);  //  разряды в буфере не в порядке машины, без копирования не прочитать
+#endif
+}
+
+void big_integer::swap(big_integer &other) {
+    data.swap(other.data);
+}
+
 void big_integer::shrink_to_fit() {
     while (size() > 1 && data.back() == 0) {
         data.pop_back();
     }
     if (size() == 1 && data.back() == 0) {
-        sign = false;
+        set_sign(false);
     }
 }
@@ -1,7 +1,10 @@
 #include "optimized_storage.h"
+#include "small_divisor.h"
 #include <vector>
 #include <string>
 #include <functional>
+#include <type_traits>
+#include <iosfwd>
 
 #ifndef BIG_INTEGER_H
 #define BIG_INTEGER_H
@@ -15,8 +18,7 @@ private:
 
     ///  @variables
 private:
-    optimized_storage data;  //  std::vector<uint32_t>
-    bool sign;
+    optimized_storage data;  //  std::vector<uint32_t> и знак числа
 
     ///  @methods
 public:
@@ -30,6 +32,14 @@ public:
 
     explicit big_integer(const std::string &str);
 
+    big_integer(const std::string &str, uint32_t base);  //  основание от 2 до 36, цифры 0-9 и a-z в любом регистре
+
+    static void set_thread_count(size_t n);  //  потоки для умножения больших чисел, 1 - без пула; не вызывать во время вычислений
+
+    static size_t thread_count();
+
+    size_t hash() const;  //  по разрядам, без перевода в строку; для длинных чисел кэшируется в буфере
+
     ~big_integer();
 
     big_integer &operator=(const big_integer &other);
@@ -44,6 +54,37 @@ public:
 
     big_integer &operator%=(const big_integer &rhs);
 
+    //  операции с встроенными целыми выполняются на месте однолимбовыми ядрами, без временного big_integer
+    template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    big_integer &operator+=(const T rhs) {
+        return add_primitive(magnitude(rhs), is_negative(rhs));
+    }
+
+    template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    big_integer &operator-=(const T rhs) {
+        return add_primitive(magnitude(rhs), !is_negative(rhs));
+    }
+
+    template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    big_integer &operator*=(const T rhs) {
+        return mul_primitive(magnitude(rhs), is_negative(rhs));
+    }
+
+    template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    big_integer &operator/=(const T rhs) {
+        return div_primitive(magnitude(rhs), is_negative(rhs));
+    }
+
+    template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    big_integer &operator%=(const T rhs) {
+        return mod_primitive(magnitude(rhs), is_negative(rhs));
+    }
+
+    //  деление на заранее подготовленный делитель без аппаратного деления, с округлением к нулю
+    big_integer &operator/=(const small_divisor &rhs);
+
+    big_integer &operator%=(const small_divisor &rhs);  //  знак остатка совпадает со знаком делимого
+
     big_integer &operator&=(const big_integer &rhs);
 
     big_integer &operator|=(const big_integer &rhs);
@@ -68,6 +109,19 @@ public:
 
     big_integer operator--(int);
 
+    //  биты бесконечного дополнительного кода, как у &, | и ~; без временных чисел, за один проход или O(1)
+    size_t bit_length() const;  //  длина дополнительного кода без знакового бита: 0 для 0 и -1, 3 для 7 и -8
+
+    bool test_bit(size_t k) const;  //  у отрицательных все биты выше модуля единичные
+
+    big_integer &set_bit(size_t k, bool value = true);
+
+    size_t popcount() const;  //  количество бит, отличных от знакового: единиц для x >= 0, нулей для x < 0
+
+    size_t trailing_zeros() const;  //  номер младшего единичного бита, одинаковый у x и -x; 0 для 0
+
+    friend int compare(const big_integer &a, const big_integer &b);
+
     friend bool operator==(const big_integer &a, const big_integer &b);
 
     friend bool operator!=(const big_integer &a, const big_integer &b);
@@ -82,9 +136,67 @@ public:
 
     friend std::string to_string(const big_integer &a);
 
+    friend std::string to_string(const big_integer &a, uint32_t base);
+
+    friend std::ostream &operator<<(std::ostream &s, const big_integer &a);
+
+    friend std::istream &operator>>(std::istream &s, big_integer &a);
+
+    friend big_integer pow(const big_integer &a, uint32_t n);
+
+    friend big_integer product(std::vector<big_integer> values);
+
+    friend big_integer iroot(const big_integer &a, uint32_t k);
+
+    friend big_integer divexact(const big_integer &a, const big_integer &b);
+
+    friend size_t serialized_size(const big_integer &a);
+
+    friend void serialize(const big_integer &a, void *buffer);
+
+    friend void serialize(const big_integer &a, std::ostream &out);
+
+    friend big_integer deserialize(const void *buffer, size_t bytes);
+
+    friend big_integer deserialize_view(const void *buffer, size_t bytes);
+
 private:
+    bool sign() const;
+
+    void set_sign(bool value);
+
     size_t size() const;
 
+    bool to_int64(int64_t &value) const;  //  false, если число не помещается в int64_t
+
+    void assign_int64(int64_t value);
+
+    template<typename T>
+    static bool is_negative(const T value) {
+        return std::is_signed<T>::value && static_cast<int64_t>(value) < 0;
+    }
+
+    template<typename T>
+    static uint64_t magnitude(const T value) {
+        return is_negative(value) ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    }
+
+    static big_integer from_magnitude(uint64_t magnitude, bool negative);  //  не больше двух разрядов, без кучи
+
+    //  знаковое число из модуля и знака, false если оно не помещается в int64_t
+    static bool primitive_to_int64(uint64_t magnitude, bool negative, int64_t &value);
+
+    big_integer &add_primitive(uint64_t magnitude, bool negative);
+
+    big_integer &mul_primitive(uint64_t magnitude, bool negative);
+
+    big_integer &div_primitive(uint64_t magnitude, bool negative);
+
+    big_integer &mod_primitive(uint64_t magnitude, bool negative);
+
+    //  быстрый путь для чисел из int64_t: false, если операнды длинные или op сообщил о переполнении
+    bool int64_operation(const big_integer &rhs, bool (*op)(int64_t, int64_t, int64_t &));
+
     uint32_t &operator[](size_t i);
 
     const uint32_t &operator[](size_t i) const;
@@ -101,23 +213,36 @@ private:
 
     static size_t bit_count(uint32_t a);
 
-    uint32_t count() const;  //  количество единичных бит числа
+    bool has_single_bit() const;  //  модуль - степень двойки
 
     uint32_t clear_log2() const;  // логарифм от степени двойки
 
-    static std::pair<big_integer, uint32_t> short_div(const big_integer &a, uint32_t b);  //  {целая часть, остаток}
+    size_t magnitude_bit_length() const;  //  количество значащих бит модуля числа
+
+    static void multiply(const big_integer &a, const big_integer &b, big_integer &ans);  //  ans не должен совпадать с a и b
+
+    void assign_digits(const char *first, const char *last, uint32_t base);  //  модуль из цифр без знака
+
+    static big_integer join_blocks(std::vector<big_integer> values, big_integer power);  //  сумма values[i] * power^i
 
-    uint32_t trial(uint64_t k, uint64_t m, const big_integer &d) const;
+    //  дописывает a в str, если out не nullptr - сбрасывает в него str блоками
+    static void write_digits(const big_integer &a, uint32_t base, std::string &str, std::ostream *out);
 
-    bool smaller(const big_integer &dq, uint64_t k, uint64_t m) const;
+    //  цифры x >= 0 от старшей к младшей, с нулями до min_digits; powers[0, k) - делители половин,
+    //  inverses[i] = reciprocal(powers[i]), x < powers[k - 1]^2
+    static void write_digits(const big_integer &x, const std::vector<big_integer> &powers,
+                             const std::vector<big_integer> &inverses, size_t k, uint32_t base, size_t min_digits,
+                             std::string &str, std::ostream *out);
 
-    void difference(const big_integer &dq, uint64_t k, uint64_t m);
+    static big_integer reciprocal(const big_integer &p);  //  floor(BASE^(2s) / p), s - число разрядов p > 0
 
     void to_additional_code(size_t n_digits);
 
     big_integer &bitwise_operation(const big_integer &rhs, const func &f);
 
     void shrink_to_fit();
+
+    void swap(big_integer &other);
 };
 
 big_integer operator+(big_integer a, const big_integer &b);
@@ -130,6 +255,45 @@ big_integer operator/(big_integer a, const big_integer &b);
 
 big_integer operator%(big_integer a, const big_integer &b);
 
+template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+big_integer operator+(big_integer a, const T b) {
+    return a += b;
+}
+
+template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+big_integer operator+(const T a, big_integer b) {
+    return b += a;
+}
+
+template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+big_integer operator-(big_integer a, const T b) {
+    return a -= b;
+}
+
+template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+big_integer operator*(big_integer a, const T b) {
+    return a *= b;
+}
+
+template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+big_integer operator*(const T a, big_integer b) {
+    return b *= a;
+}
+
+template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+big_integer operator/(big_integer a, const T b) {
+    return a /= b;
+}
+
+template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+big_integer operator%(big_integer a, const T b) {
+    return a %= b;
+}
+
+big_integer operator/(big_integer a, const small_divisor &b);
+
+big_integer operator%(big_integer a, const small_divisor &b);
+
 big_integer operator&(big_integer a, const big_integer &b);
 
 big_integer operator|(big_integer a, const big_integer &b);
@@ -140,6 +304,10 @@ big_integer operator<<(big_integer a, int b);
 
 big_integer operator>>(big_integer a, int b);
 
+//  -1, 0 или 1 за один проход со старшего разряда; на ней построены все операторы сравнения,
+//  поэтому std::less<big_integer> в std::sort и std::map тоже сравнивает за один проход
+int compare(const big_integer &a, const big_integer &b);
+
 bool operator==(const big_integer &a, const big_integer &b);
 
 bool operator!=(const big_integer &a, const big_integer &b);
@@ -154,6 +322,52 @@ bool operator>=(const big_integer &a, const big_integer &b);
 
 std::string to_string(const big_integer &a);
 
+std::string to_string(const big_integer &a, uint32_t base);  //  цифры больше 9 - строчные латинские буквы
+
+big_integer pow(const big_integer &a, uint32_t n);
+
+big_integer product(std::vector<big_integer> values);  //  произведение сбалансированным деревом, пустое - 1
+
+template<typename Iterator>
+big_integer product(Iterator first, Iterator last) {
+    return product(std::vector<big_integer>(first, last));
+}
+
+big_integer isqrt(const big_integer &a);  //  floor(sqrt(a)), a >= 0
+
+big_integer iroot(const big_integer &a, uint32_t k);  //  floor(a^(1/k)), с округлением к нулю для отрицательных a
+
+//  a / b, если b делит a нацело, за время порядка одного умножения; иначе результат не определен
+big_integer divexact(const big_integer &a, const big_integer &b);
+
+//  потоковый вывод блоками цифр без строки целиком, учитывает hex/oct/dec
 std::ostream &operator<<(std::ostream &s, const big_integer &a);
 
+//  читает [+-]цифры прямо из буфера потока, учитывает hex/oct/dec
+std::istream &operator>>(std::istream &s, big_integer &a);
+
+//  двоичный формат: 8 байт заголовка (число разрядов << 1 | знак), затем разряды, все little-endian
+size_t serialized_size(const big_integer &a);
+
+void serialize(const big_integer &a, void *buffer);  //  пишет serialized_size(a) байт
+
+std::vector<uint8_t> serialize(const big_integer &a);
+
+void serialize(const big_integer &a, std::ostream &out);  //  заголовок и разряды прямо в поток, без буфера на все число
+
+big_integer deserialize(const void *buffer, size_t bytes);  //  копирует разряды, лишние байты после числа не читает
+
+//  без копирования: длинное число ссылается на разряды в buffer до первого изменения, buffer должен пережить
+//  число и все его копии, а разряды (buffer + 8) должны быть выровнены на 4 байта
+big_integer deserialize_view(const void *buffer, size_t bytes);
+
+namespace std {
+    template<>
+    struct hash<big_integer> {
+        size_t operator()(const big_integer &a) const {
+            return a.hash();
+        }
+    };
+}
+
 #endif //BIG_INTEGER_H
\ No newline at end of file
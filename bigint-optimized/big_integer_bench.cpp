@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <atomic>
+#include <new>
+
+#include "big_integer.h"
+#include "big_integer_gmp.h"
+#include "pool_resource.h"
+#include "storage_stats.h"
+#include "operation_trace.h"
+
+namespace {
+    std::atomic<size_t> heap_allocations(0);
+}
+
+void *operator new(size_t size) {
+    ++heap_allocations;
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    using bench_clock = std::chrono::steady_clock;
+
+    struct measurement {
+        double ns;  ///  average time of a call
+        double allocations;  ///  average number of operator new calls per call
+    };
+
+    std::mt19937 rng(42);
+
+    ///  random non-negative number with exactly `bits` significant bits, O(n log n) via halving
+    big_integer random_bits(size_t bits) {
+        if (bits <= 30) {
+            return static_cast<int>((rng() & ((1u << bits) - 1)) | (1u << (bits - 1)));
+        }
+        const size_t low = bits / 2;
+        big_integer lo = random_bits(low);
+        if (rng() % 2 == 0) {
+            lo >>= 1;
+        }
+        return (random_bits(bits - low) << static_cast<int>(low)) + lo;
+    }
+
+    ///  runs f until at least min_time elapsed
+    template<typename F>
+    measurement measure(F f, double min_time = 0.2) {
+        size_t iterations = 0;
+        const size_t allocations = heap_allocations;
+        const auto start = bench_clock::now();
+        double elapsed = 0;
+        do {
+            f();
+            ++iterations;
+            elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+        } while (elapsed < min_time);
+        return {elapsed * 1e9 / iterations, static_cast<double>(heap_allocations - allocations) / iterations};
+    }
+
+    ///  efficiency = t(1 thread) / (threads * t(threads)), the first row of (name, size) is the baseline;
+    ///  gmp_ratio = t / t(gmp) is printed only for benchmarks that have a GMP counterpart
+    void report(const std::string &name, size_t size, measurement m, size_t threads = 1, double gmp_ratio = 0) {
+        static std::map<std::pair<std::string, size_t>, double> single_thread;
+        const auto it = single_thread.insert({{name, size}, m.ns * threads}).first;
+        std::cout << name << ',' << size << ',' << threads << ',' << static_cast<uint64_t>(m.ns) << ','
+                  << it->second / (m.ns * threads) << ',' << m.allocations << ',';
+        if (gmp_ratio != 0) {
+            std::cout << gmp_ratio;
+        }
+        std::cout << std::endl;
+    }
+
+    void bench_roots() {
+        for (size_t bits : {10000, 100000, 1000000}) {
+            const big_integer a = random_bits(bits);
+            report("isqrt", bits, measure([&a] { isqrt(a); }));
+            report("iroot3", bits, measure([&a] { iroot(a, 3); }));
+        }
+    }
+
+    void bench_mul_threads() {
+        const size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+        for (size_t bits : {100000, 1000000}) {
+            const big_integer a = random_bits(bits), b = random_bits(bits);
+            for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+                big_integer::set_thread_count(threads);
+                report("mul_threads", bits, measure([&a, &b] { a * b; }), threads);
+            }
+        }
+        big_integer::set_thread_count(1);
+    }
+
+    void bench_div() {
+        for (size_t bits : {1000, 10000, 100000}) {
+            const big_integer a = random_bits(2 * bits), b = random_bits(bits);
+            report("div", bits, measure([&a, &b] { a / b; }));
+            const big_integer c = random_bits(bits) * b;  //  known to be divisible
+            report("div_divisible", bits, measure([&c, &b] { c / b; }));
+            report("divexact", bits, measure([&c, &b] { divexact(c, b); }));
+            report("mul_for_divexact", bits, measure([&a, &b] { a * b; }));
+        }
+    }
+
+    ///  workloads dominated by allocation of short numbers
+    void merge_workload(size_t n) {
+        std::mt19937 gen(1);
+        std::vector<big_integer> v;
+        for (size_t i = 0; i < n; ++i) {
+            v.emplace_back(static_cast<int>(gen() >> 1u) + 1);
+        }
+        while (v.size() > 1) {
+            const size_t i = gen() % v.size();
+            std::swap(v[i], v.back());
+            big_integer a = v.back();
+            v.pop_back();
+            v[gen() % v.size()] *= a;
+        }
+    }
+
+    void accumulate_workload(size_t n) {
+        std::mt19937 gen(1);
+        big_integer result = 1;
+        for (size_t i = 0; i < n; ++i) {
+            result *= RAND_MAX;
+            result += static_cast<int>(gen() >> 1u);
+        }
+    }
+
+    void copy_mutate_workload(size_t n) {
+        std::vector<big_integer> v(n, big_integer(1) << 200);
+        for (auto &x : v) {
+            ++x;
+        }
+    }
+
+    void bench_alloc() {
+        const struct {
+            const char *name;
+            void (*run)(size_t);
+        } workloads[] = {
+                {"merge", merge_workload},
+                {"accumulate", accumulate_workload},
+                {"copy_mutate", copy_mutate_workload},
+        };
+        for (const auto &w : workloads) {
+            for (size_t n : {100, 1000}) {
+                report(std::string(w.name) + "/default", n, measure([&w, n] { w.run(n); }));
+                pool_resource pool;
+                memory_resource *previous = set_default_resource(&pool);
+                report(std::string(w.name) + "/pool", n, measure([&w, n] { w.run(n); }));
+                set_default_resource(previous);
+            }
+        }
+    }
+
+    ///  int64 and 128-512 bit values, names carry the static storage size the bench was built with
+    void bench_small() {
+        const std::string suffix = "/inline=" + std::to_string(optimized_storage::MAX_STATIC_SIZE);
+        const size_t n = 1000;
+        for (size_t bits : {31, 62, 64, 128, 256, 384, 512}) {
+            std::vector<big_integer> v;
+            for (size_t i = 0; i < n; ++i) {
+                v.push_back(random_bits(bits));
+            }
+            const big_integer m = random_bits(bits / 2);
+            report("small_copy" + suffix, bits, measure([&v] { std::vector<big_integer> copy(v); }));
+            report("small_add" + suffix, bits, measure([&v] {
+                for (size_t i = 0; i + 1 < v.size(); ++i) {
+                    v[i] + v[i + 1];
+                }
+            }));
+            report("small_mul" + suffix, bits, measure([&v] {
+                for (size_t i = 0; i + 1 < v.size(); ++i) {
+                    v[i] * v[i + 1];
+                }
+            }));
+            report("small_mod" + suffix, bits, measure([&v, &m] {
+                for (const auto &x : v) {
+                    x % m;
+                }
+            }));
+        }
+    }
+
+    ///  random non-negative GMP number with `bits` significant bits
+    big_integer_gmp random_bits_gmp(size_t bits) {
+        big_integer_gmp a;
+        a.random(bits - 1, rng);
+        return (a < 0 ? -a : a) + (big_integer_gmp(1) << static_cast<int>(bits - 1));
+    }
+
+    enum operation {
+        ADD, SUB, MUL, DIV, MOD, SHL, SHR, AND, OR, XOR, TO_STRING, FROM_STRING, COPY
+    };
+
+    template<typename Number>
+    measurement measure_operation(operation op, const Number &a, const Number &b, const std::string &str) {
+        const int shift = 1000;
+        switch (op) {
+            case ADD:
+                return measure([&a, &b] { a + b; });
+            case SUB:
+                return measure([&a, &b] { a - b; });
+            case MUL:
+                return measure([&a, &b] { a * b; });
+            case DIV:
+                return measure([&a, &b] { a / b; });
+            case MOD:
+                return measure([&a, &b] { a % b; });
+            case SHL:
+                return measure([&a] { a << shift; });
+            case SHR:
+                return measure([&a] { a >> shift; });
+            case AND:
+                return measure([&a, &b] { a & b; });
+            case OR:
+                return measure([&a, &b] { a | b; });
+            case XOR:
+                return measure([&a, &b] { a ^ b; });
+            case TO_STRING:
+                return measure([&a] { to_string(a); });
+            case FROM_STRING:
+                return measure([&str] { Number x(str); });
+            default:
+                return measure([&a] { Number copy(a); });  ///  COW sharing for big_integer, deep copy for GMP
+        }
+    }
+
+    ///  every operation for both implementations, size is in 32-bit limbs; quadratic operations are capped,
+    ///  so that a full run takes minutes: at 10^6 limbs a single division or conversion would take hours
+    void bench_ops() {
+        const struct {
+            const char *name;
+            operation op;
+            size_t max_limbs;
+        } cases[] = {
+                {"add", ADD, 1000000},
+                {"sub", SUB, 1000000},
+                {"mul", MUL, 100000},
+                {"div", DIV, 10000},
+                {"mod", MOD, 10000},
+                {"shl", SHL, 1000000},
+                {"shr", SHR, 1000000},
+                {"and", AND, 1000000},
+                {"or", OR, 1000000},
+                {"xor", XOR, 1000000},
+                {"to_string", TO_STRING, 10000},
+                {"from_string", FROM_STRING, 10000},
+                {"copy", COPY, 1000000},
+        };
+        for (size_t limbs = 1; limbs <= 1000000; limbs *= 10) {
+            const size_t bits = 32 * limbs;
+            const big_integer a = random_bits(bits), b = random_bits(bits), a2 = random_bits(2 * bits);
+            const big_integer_gmp ga = random_bits_gmp(bits), gb = random_bits_gmp(bits);
+            const big_integer_gmp ga2 = random_bits_gmp(2 * bits);
+            const std::string str = limbs <= 10000 ? to_string(a) : std::string();
+            for (const auto &c : cases) {
+                if (limbs > c.max_limbs) {
+                    continue;
+                }
+                const bool wide = c.op == DIV || c.op == MOD;  ///  dividend is twice as long as divisor
+                const measurement gmp = measure_operation(c.op, wide ? ga2 : ga, gb, str);
+                const measurement own = measure_operation(c.op, wide ? a2 : a, b, str);
+                report(std::string("ops/") + c.name, limbs, own, 1, own.ns / gmp.ns);
+                report(std::string("ops/") + c.name + "/gmp", limbs, gmp);
+            }
+        }
+    }
+
+    ///  balanced products below KARATSUBA_THRESHOLD = 48 limbs, i.e. the schoolbook base case alone
+    void bench_mul_basecase() {
+        for (size_t limbs : {2, 4, 8, 16, 24, 32, 40, 47}) {
+            const big_integer a = random_bits(32 * limbs), b = random_bits(32 * limbs);
+            const big_integer_gmp a_gmp = random_bits_gmp(32 * limbs), b_gmp = random_bits_gmp(32 * limbs);
+            const measurement own = measure([&a, &b] { a * b; });
+            const measurement gmp = measure([&a_gmp, &b_gmp] { a_gmp * b_gmp; });
+            report("mul_basecase", limbs, own, 1, own.ns / gmp.ns);
+        }
+    }
+
+    ///  balanced Karatsuba products, the base case is benchmarked by bench_mul_basecase, size is in limbs
+    void bench_mul() {
+        for (size_t limbs : {500, 1000, 2000, 5000}) {
+            const big_integer a = random_bits(32 * limbs), b = random_bits(32 * limbs);
+            const big_integer_gmp a_gmp = random_bits_gmp(32 * limbs), b_gmp = random_bits_gmp(32 * limbs);
+            const measurement own = measure([&a, &b] { a * b; });
+            const measurement gmp = measure([&a_gmp, &b_gmp] { a_gmp * b_gmp; });
+            report("mul", limbs, own, 1, own.ns / gmp.ns);
+        }
+    }
+
+    ///  long operand of 10^5 limbs times a short one, size is the length of the short operand in limbs
+    void bench_mul_unbalanced() {
+        const size_t long_limbs = 100000;
+        const big_integer a = random_bits(32 * long_limbs);
+        const big_integer_gmp a_gmp = random_bits_gmp(32 * long_limbs);
+        for (size_t limbs : {1, 2, 3, 4, 16, 64, 256, 4096}) {
+            const big_integer b = random_bits(32 * limbs);
+            const big_integer_gmp b_gmp = random_bits_gmp(32 * limbs);
+            const measurement own = measure([&a, &b] { a * b; });
+            const measurement gmp = measure([&a_gmp, &b_gmp] { a_gmp * b_gmp; });
+            report("mul_unbalanced", limbs, own, 1, own.ns / gmp.ns);
+        }
+    }
+
+    ///  division of a long number by a one-limb constant, size is the length of the dividend in limbs;
+    ///  div_small passes the constant as an integer, div_small_reused keeps a prepared small_divisor
+    void bench_div_small() {
+        for (size_t limbs : {100, 10000, 100000}) {
+            const big_integer a = random_bits(32 * limbs);
+            const big_integer_gmp a_gmp = random_bits_gmp(32 * limbs);
+            for (uint32_t d : {10u, 1000000000u, 1000000007u}) {
+                const std::string suffix = "/d=" + std::to_string(d);
+                const small_divisor divisor(d);
+                const big_integer_gmp d_gmp(std::to_string(d));
+                const measurement gmp = measure([&a_gmp, &d_gmp] { a_gmp / d_gmp; });
+                const measurement own = measure([&a, d] { a / d; });
+                report("div_small" + suffix, limbs, own, 1, own.ns / gmp.ns);
+                const measurement reused = measure([&a, &divisor] { a / divisor; });
+                report("div_small_reused" + suffix, limbs, reused, 1, reused.ns / gmp.ns);
+            }
+        }
+    }
+
+    ///  decimal conversion of doubling sizes in limbs: subquadratic conversion grows about 3x per doubling
+    void bench_to_string() {
+        for (size_t limbs : {12500, 25000, 50000, 100000}) {
+            const big_integer a = random_bits(32 * limbs);
+            const big_integer_gmp a_gmp = random_bits_gmp(32 * limbs);
+            const measurement own = measure([&a] { to_string(a); });
+            const measurement gmp = measure([&a_gmp] { to_string(a_gmp); });
+            report("to_string", limbs, own, 1, own.ns / gmp.ns);
+        }
+    }
+
+    struct benchmark {
+        const char *name;
+        void (*run)();
+    };
+
+    const benchmark benchmarks[] = {
+            {"roots", bench_roots},
+            {"mul_threads", bench_mul_threads},
+            {"div", bench_div},
+            {"div_small", bench_div_small},
+            {"to_string", bench_to_string},
+            {"mul_basecase", bench_mul_basecase},
+            {"mul", bench_mul},
+            {"mul_unbalanced", bench_mul_unbalanced},
+            {"alloc", bench_alloc},
+            {"small", bench_small},
+            {"ops", bench_ops},
+    };
+}
+
+///  usage: big_integer_bench [name...], without arguments runs everything
+int main(int argc, char **argv) {
+    std::cout << "benchmark,size,threads,ns,efficiency,allocations,gmp_ratio" << std::endl;
+    for (const auto &b : benchmarks) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            selected |= std::strcmp(argv[i], b.name) == 0;
+        }
+        if (selected) {
+            b.run();
+        }
+    }
+    storage_stats::print(std::cerr);
+    operation_trace::print(std::cerr);
+    return 0;
+}
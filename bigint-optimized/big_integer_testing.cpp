@@ -1,13 +1,38 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <random>
+#include <thread>
 #include <vector>
 #include <utility>
+#include <unordered_set>
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 #include "big_integer.h"
 #include "big_integer_gmp.h"
+#include "pool_resource.h"
+#include "scratch_arena.h"
+#include "big_integer_view.h"
+#include "storage_stats.h"
+#include "operation_trace.h"
+
+namespace {
+    ///  prints the storage counters and operation histograms of the whole run after the last test
+    struct storage_stats_environment : ::testing::Environment {
+        void TearDown() override {
+            storage_stats::print(std::cout);
+            operation_trace::print(std::cout);
+        }
+    };
+
+    ::testing::Environment *const storage_stats_env =
+            ::testing::AddGlobalTestEnvironment(new storage_stats_environment);
+}
 
 TEST(correctness, two_plus_two) {
     EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -834,4 +859,822 @@ TEST(correctness_twos_complement, all_ones) {
     big_integer your_ans = your_a & your_b;
 
     EXPECT_EQ(to_string(gmp_ans), to_string(your_ans));
-}
\ No newline at end of file
+}
+
+TEST(correctness_twos_complement, two_limb_negative) {
+    //  дополнительный код -(2^64 - 3) на двух разрядах начинается с нулевого разряда
+    const std::string a = "-18446744073709551613", b = "-4294967295";
+    big_integer_gmp gmp_a(a), gmp_b(b);
+    big_integer your_a(a), your_b(b);
+
+    EXPECT_EQ("-4294967293", to_string(your_a | your_b));
+    EXPECT_EQ("18446744069414584322", to_string(your_a ^ your_b));
+    EXPECT_EQ(to_string(gmp_a | gmp_b), to_string(your_a | your_b));
+    EXPECT_EQ(to_string(gmp_a ^ gmp_b), to_string(your_a ^ your_b));
+    EXPECT_EQ(to_string(gmp_a & gmp_b), to_string(your_a & your_b));
+    EXPECT_EQ(to_string(gmp_b ^ gmp_a), to_string(your_b ^ your_a));
+}
+
+TEST(correctness, isqrt) {
+    EXPECT_EQ(0, isqrt(0));
+    EXPECT_EQ(1, isqrt(1));
+    EXPECT_EQ(1, isqrt(3));
+    EXPECT_EQ(2, isqrt(4));
+    EXPECT_EQ(46340, isqrt(std::numeric_limits<int>::max()));
+    EXPECT_EQ(big_integer("1000000000000000000000"), isqrt(big_integer("1000000000000000000000000000000000000000000")));
+    EXPECT_EQ(big_integer("999999999999999999999"), isqrt(big_integer("999999999999999999999999999999999999999999")));
+    EXPECT_THROW(isqrt(-1), std::runtime_error);
+}
+
+TEST(correctness, iroot) {
+    EXPECT_EQ(3, iroot(27, 3));
+    EXPECT_EQ(2, iroot(26, 3));
+    EXPECT_EQ(-3, iroot(-27, 3));
+    EXPECT_EQ(big_integer("123456789"), iroot(big_integer("123456789") * big_integer("123456789") * big_integer("123456789"), 3));
+    EXPECT_EQ(2, iroot(big_integer(1) << 100, 100));
+    EXPECT_EQ(1, iroot((big_integer(1) << 100) - 1, 100));
+    EXPECT_THROW(iroot(5, 0), std::runtime_error);
+    EXPECT_THROW(iroot(-5, 4), std::runtime_error);
+}
+
+TEST(correctness_random, roots) {
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer_gmp a;
+        a.random(max_size, rng);
+        big_integer A = big_integer(to_string(a));
+        if (A < 0) {
+            A = -A;
+        }
+        for (uint32_t k = 2; k <= 5; ++k) {
+            big_integer r = iroot(A, k), lo = 1, hi = 1;
+            for (uint32_t i = 0; i < k; ++i) {
+                lo *= r;
+                hi *= r + 1;
+            }
+            EXPECT_LE(lo, A);
+            EXPECT_GT(hi, A);
+        }
+    }
+}
+
+TEST(correctness, pow) {
+    EXPECT_EQ(1, pow(big_integer(0), 0));
+    EXPECT_EQ(0, pow(big_integer(0), 5));
+    EXPECT_EQ(1024, pow(big_integer(2), 10));
+    EXPECT_EQ(-32, pow(big_integer(-2), 5));
+    EXPECT_EQ(16, pow(big_integer(-2), 4));
+    EXPECT_EQ(-27, pow(big_integer(-3), 3));
+    EXPECT_EQ(big_integer(1) << 640, pow(big_integer(1) << 64, 10));
+    EXPECT_EQ(big_integer("1000000000000000000000000000000"), pow(big_integer(10), 30));
+    EXPECT_EQ(big_integer("-1481113296616977741464105532513750734030421355207"), pow(big_integer(-7), 57));
+    EXPECT_THROW(pow(big_integer(1) << 64, 1u << 26), std::runtime_error);
+}
+
+TEST(correctness_random, pow) {
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer_gmp a;
+        a.random(max_size / 16, rng);
+        big_integer A = big_integer(to_string(a)), expected = 1;
+        for (uint32_t n = 0; n <= 20; ++n) {
+            EXPECT_EQ(expected, pow(A, n));
+            expected *= A;
+        }
+    }
+}
+
+TEST(correctness_random, mul_huge) {
+    std::default_random_engine rng(42);
+    for (size_t bits : {3000, 40000}) {
+        big_integer_gmp a, b;
+        a.random(bits, rng);
+        b.random(bits / 3, rng);
+        big_integer A = big_integer(to_string(a)), B = big_integer(to_string(b));
+        EXPECT_EQ(to_string(a * a), to_string(A * A));
+        EXPECT_EQ(to_string(a * b), to_string(A * B));
+    }
+}
+
+TEST(correctness_random, mul_parallel) {
+    big_integer a = pow(big_integer(myrand()), 2500) - 1, b = pow(big_integer(myrand()), 1500) + 1;
+    big_integer expected = a * b;
+    for (size_t threads : {2, 4, 7}) {
+        big_integer::set_thread_count(threads);
+        EXPECT_EQ(threads, big_integer::thread_count());
+        EXPECT_EQ(expected, a * b);
+        EXPECT_EQ(expected, b * a);
+        EXPECT_EQ(expected * expected, pow(expected, 2));
+    }
+    big_integer::set_thread_count(1);
+    EXPECT_EQ(1u, big_integer::thread_count());
+}
+
+TEST(correctness, product) {
+    std::vector<big_integer> x;
+    EXPECT_EQ(1, product(x.begin(), x.end()));
+    big_integer factorial = 1;
+    for (int i = 1; i <= 500; ++i) {
+        factorial *= i;
+        x.emplace_back(i);
+    }
+    EXPECT_EQ(factorial, product(x.begin(), x.end()));
+    x.emplace_back(-3);
+    EXPECT_EQ(-3 * factorial, product(x));
+    x.emplace_back(0);
+    EXPECT_EQ(0, product(x));
+}
+
+TEST(correctness, product_randomized) {
+    for (size_t threads : {1, 3}) {
+        big_integer::set_thread_count(threads);
+        std::vector<big_integer> x;
+        for (size_t i = 0; i != number_of_multipliers; ++i) {
+            x.emplace_back(myrand());
+        }
+        int values[] = {1, 2, 3};
+        EXPECT_EQ(merge_all(x), product(x));
+        EXPECT_EQ(6, product(values, values + 3));
+    }
+    big_integer::set_thread_count(1);
+}
+
+TEST(correctness, div_negative_pow2) {
+    big_integer a = -((big_integer(1) << 40) + 1), b = big_integer(1) << 33;
+    EXPECT_EQ(-128, a / b);
+    EXPECT_EQ(-1, a % b);
+}
+
+TEST(correctness, scratch_arena_reuse) {
+    big_integer a = pow(big_integer(myrand()), 700), b = pow(big_integer(myrand()), 300) + 1;
+    big_integer q = a / b;
+    scratch_arena &arena = scratch_arena::local();
+    arena.reset_statistics();
+    EXPECT_EQ(q, a / b);
+    EXPECT_EQ(a, q * b + a % b);
+    EXPECT_GT(arena.get_statistics().requests, 0u);
+    EXPECT_EQ(0u, arena.get_statistics().blocks);
+}
+
+TEST(correctness, pool_resource) {
+    pool_resource pool;
+    memory_resource *previous = set_default_resource(&pool);
+    EXPECT_EQ(&pool, get_default_resource());
+    {
+        std::vector<big_integer> x;
+        for (size_t i = 0; i != number_of_multipliers; ++i) {
+            x.emplace_back(myrand());
+        }
+        big_integer a = merge_all(x), b = a;
+        b += 1;
+        EXPECT_EQ(a + 1, b);
+        EXPECT_EQ(a, product(x));
+        EXPECT_GT(pool.get_statistics().allocations, 0u);
+        EXPECT_GT(pool.get_statistics().bytes_in_use, 0u);
+    }
+    EXPECT_EQ(0u, pool.get_statistics().bytes_in_use);
+    EXPECT_EQ(&pool, set_default_resource(previous));
+    EXPECT_EQ(new_delete_resource(), get_default_resource());
+}
+
+TEST(correctness, int64_boundaries) {
+    std::vector<std::string> values = {"0", "1", "-1", "2", "-3", "4294967295", "4294967296", "-4294967296",
+                                       "9223372036854775807", "-9223372036854775807", "-9223372036854775808",
+                                       "9223372036854775808", "-9223372036854775809", "18446744073709551615",
+                                       "3037000499", "3037000500", "-3037000500"};
+    for (const auto &a : values) {
+        for (const auto &b : values) {
+            big_integer_gmp ga(a), gb(b);
+            big_integer x(a), y(b);
+            EXPECT_EQ(to_string(ga + gb), to_string(x + y));
+            EXPECT_EQ(to_string(ga - gb), to_string(x - y));
+            EXPECT_EQ(to_string(ga * gb), to_string(x * y));
+            EXPECT_EQ(to_string(ga & gb), to_string(x & y));
+            EXPECT_EQ(to_string(ga | gb), to_string(x | y));
+            EXPECT_EQ(to_string(ga ^ gb), to_string(x ^ y));
+            EXPECT_EQ(ga < gb, x < y);
+            EXPECT_EQ(ga == gb, x == y);
+            if (b != "0") {
+                EXPECT_EQ(to_string(ga / gb), to_string(x / y));
+                EXPECT_EQ(to_string(ga % gb), to_string(x % y));
+            }
+        }
+        for (int shift : {0, 1, 2, 31, 32, 33, 62, 63, 64, 65, 100}) {
+            EXPECT_EQ(to_string(big_integer_gmp(a) << shift), to_string(big_integer(a) << shift));
+            EXPECT_EQ(to_string(big_integer_gmp(a) >> shift), to_string(big_integer(a) >> shift));
+        }
+    }
+}
+
+TEST(correctness, shr_negative_rounding) {
+    EXPECT_EQ(-2, big_integer(-4) >> 1);
+    EXPECT_EQ(-1, big_integer(-1) >> 1);
+    EXPECT_EQ(-1, big_integer(-1) >> 1000);
+    EXPECT_EQ(-(big_integer(1) << 36), -(big_integer(1) << 100) >> 64);
+    EXPECT_EQ(-(big_integer(1) << 36) - 1, (-(big_integer(1) << 100) - 1) >> 64);
+    EXPECT_EQ(-1, -(big_integer(1) << 100) >> 200);
+}
+
+TEST(correctness, primitive_operands) {
+    const std::vector<int64_t> signed_values = {0, 1, -1, 7, -10, 1000000007, INT32_MIN, INT32_MAX,
+                                                INT64_MIN, INT64_MAX, -4294967296LL, 4294967297LL};
+    const std::vector<uint64_t> unsigned_values = {0, 1, UINT32_MAX, 4294967296ULL, UINT64_MAX};
+    std::vector<std::string> numbers = {"0", "-1", "4294967295", "-9223372036854775808", "18446744073709551616"};
+    std::mt19937 rng(35);
+    for (int bits : {64, 100, 1000}) {
+        numbers.push_back(to_string(big_integer_gmp().random(bits, rng)));
+        numbers.push_back(to_string(-big_integer_gmp().random(bits, rng)));
+    }
+    for (const auto &a : numbers) {
+        const big_integer x(a);
+        const big_integer_gmp ga(a);
+        for (int64_t p : signed_values) {
+            const big_integer_gmp gp(std::to_string(p));
+            EXPECT_EQ(to_string(ga + gp), to_string(x + p));
+            EXPECT_EQ(to_string(gp + ga), to_string(p + x));
+            EXPECT_EQ(to_string(ga - gp), to_string(x - p));
+            EXPECT_EQ(to_string(ga * gp), to_string(x * p));
+            EXPECT_EQ(to_string(gp * ga), to_string(p * x));
+            if (p != 0) {
+                EXPECT_EQ(to_string(ga / gp), to_string(x / p));
+                EXPECT_EQ(to_string(ga % gp), to_string(x % p));
+            }
+        }
+        for (uint64_t p : unsigned_values) {
+            const big_integer_gmp gp(std::to_string(p));
+            big_integer y = x;
+            EXPECT_EQ(to_string(ga + gp), to_string(y += p));
+            y = x;
+            EXPECT_EQ(to_string(ga - gp), to_string(y -= p));
+            y = x;
+            EXPECT_EQ(to_string(ga * gp), to_string(y *= p));
+            if (p != 0) {
+                y = x;
+                EXPECT_EQ(to_string(ga / gp), to_string(y /= p));
+                y = x;
+                EXPECT_EQ(to_string(ga % gp), to_string(y %= p));
+            }
+        }
+    }
+    EXPECT_THROW(big_integer(5) / 0, std::runtime_error);
+    EXPECT_THROW(big_integer(5) % 0u, std::runtime_error);
+}
+
+TEST(correctness_random, compare) {
+    std::mt19937 rng(36);
+    std::vector<std::pair<big_integer, big_integer_gmp>> values;
+    for (int bits : {1, 40, 63, 64, 65, 200, 1000}) {
+        for (size_t i = 0; i != 4; ++i) {
+            big_integer_gmp g;
+            g.random(bits, rng);
+            if (i % 2 == 1) {
+                g = -g;
+            }
+            values.emplace_back(big_integer(to_string(g)), g);
+        }
+    }
+    values.emplace_back(values.back());
+    for (const auto &a : values) {
+        for (const auto &b : values) {
+            const int expected = (a.second > b.second) - (a.second < b.second);
+            EXPECT_EQ(expected, compare(a.first, b.first));
+            EXPECT_EQ(a.second < b.second, a.first < b.first);
+            EXPECT_EQ(a.second > b.second, a.first > b.first);
+            EXPECT_EQ(a.second <= b.second, a.first <= b.first);
+            EXPECT_EQ(a.second >= b.second, a.first >= b.first);
+            EXPECT_EQ(a.second == b.second, a.first == b.first);
+            EXPECT_EQ(a.second != b.second, a.first != b.first);
+        }
+    }
+    std::vector<big_integer> sorted;
+    for (const auto &v : values) {
+        sorted.push_back(v.first);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 1; i < sorted.size(); ++i) {
+        EXPECT_LE(compare(sorted[i - 1], sorted[i]), 0);
+    }
+}
+
+TEST(correctness, hash) {
+    std::hash<big_integer> h;
+    const big_integer a = pow(big_integer(3), 500);
+    EXPECT_EQ(h(a), h(big_integer(to_string(a))));
+    EXPECT_EQ(h(big_integer(-5)), h(big_integer(10) - 15));
+    EXPECT_NE(h(a), h(-a));
+    EXPECT_NE(h(a), h(a + 1));
+
+    big_integer b = a;  //  общий буфер с кэшированным хешем
+    const size_t cached = h(b);
+    ++b;
+    EXPECT_EQ(h(big_integer(to_string(b))), h(b));
+    EXPECT_EQ(cached, h(a));
+    b -= 1;
+    EXPECT_EQ(cached, h(b));
+    b *= 7;
+    b /= 7;
+    EXPECT_EQ(cached, h(b));
+
+    std::unordered_set<big_integer> set;
+    for (int i = 0; i != 100; ++i) {
+        set.insert(a * (i % 10));
+        set.insert(big_integer(i % 20));
+    }
+    EXPECT_EQ(29u, set.size());
+    EXPECT_EQ(1u, set.count(a * 9));
+    EXPECT_EQ(0u, set.count(a * 10));
+}
+
+TEST(correctness, hash_shared_buffer_threads) {
+    const big_integer a = pow(big_integer(7), 3000);
+    const size_t expected = std::hash<big_integer>()(big_integer(to_string(a)));
+    std::vector<big_integer> copies(8, a);  //  все копии делят один буфер, кэш хеша заполняется из разных потоков
+    std::vector<size_t> hashes(copies.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < copies.size(); ++i) {
+        threads.emplace_back([&copies, &hashes, i] { hashes[i] = std::hash<big_integer>()(copies[i]); });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (size_t h : hashes) {
+        EXPECT_EQ(expected, h);
+    }
+}
+
+TEST(correctness, serialization) {
+    std::mt19937 rng(38);
+    std::vector<big_integer> values = {0, 1, -1, INT32_MIN, pow(big_integer(2), 64), -pow(big_integer(3), 1000)};
+    for (int bits : {20, 64, 100, 5000}) {
+        values.emplace_back(to_string(big_integer_gmp().random(bits, rng)));
+        values.push_back(-values.back());
+    }
+    for (const auto &a : values) {
+        const std::vector<uint8_t> buffer = serialize(a);
+        EXPECT_EQ(serialized_size(a), buffer.size());
+        EXPECT_EQ(a, deserialize(buffer.data(), buffer.size()));
+        EXPECT_EQ(a, deserialize_view(buffer.data(), buffer.size()));
+    }
+    EXPECT_EQ(std::vector<uint8_t>({2, 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0}), serialize(big_integer(5)));
+    EXPECT_EQ(std::vector<uint8_t>({3, 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0}), serialize(big_integer(-5)));
+
+    const std::vector<uint8_t> truncated = {4, 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0};
+    const std::vector<uint8_t> negative_zero = {3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    const std::vector<uint8_t> leading_zero = {4, 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0};
+    for (const auto &bad : {truncated, negative_zero, leading_zero}) {
+        EXPECT_THROW(deserialize(bad.data(), bad.size()), std::runtime_error);
+    }
+    EXPECT_THROW(deserialize(truncated.data(), 4), std::runtime_error);
+}
+
+TEST(correctness, deserialize_view) {
+    const big_integer a = pow(big_integer(7), 3000);
+    std::vector<uint8_t> buffer = serialize(a);
+    const std::vector<uint8_t> original = buffer;
+    big_integer view = deserialize_view(buffer.data(), buffer.size());
+    big_integer copy = view;  //  копия ссылается на тот же буфер
+    EXPECT_EQ(a, view);
+    EXPECT_EQ(a * 3, view * 3);
+    EXPECT_EQ(std::hash<big_integer>()(a), std::hash<big_integer>()(view));
+    view += 1;
+    EXPECT_EQ(a + 1, view);
+    EXPECT_EQ(original, buffer);
+    EXPECT_EQ(a, copy);
+    copy >>= 32;
+    EXPECT_EQ(a >> 32, copy);
+    EXPECT_EQ(original, buffer);
+    std::vector<uint8_t> shifted(buffer.size() + 1);
+    std::copy(buffer.begin(), buffer.end(), shifted.begin() + 1);
+    EXPECT_EQ(a, deserialize(shifted.data() + 1, buffer.size()));
+    EXPECT_THROW(deserialize_view(shifted.data() + 1, buffer.size()), std::runtime_error);
+}
+
+namespace {
+    //  временный файл в TMPDIR (или /tmp), удаляется при выходе из теста, даже если он упал
+    struct temp_file {
+        std::string path;
+
+        temp_file() {
+            const char *dir = std::getenv("TMPDIR");
+            std::string pattern = std::string(dir != nullptr && *dir != '\0' ? dir : "/tmp") + "/big_integer_XXXXXX";
+            const int fd = mkstemp(&pattern[0]);
+            if (fd == -1) {
+                throw std::runtime_error("Cannot create temporary file");
+            }
+            close(fd);
+            path = pattern;
+        }
+
+        temp_file(const temp_file &) = delete;
+        temp_file &operator=(const temp_file &) = delete;
+
+        ~temp_file() {
+            std::remove(path.c_str());
+        }
+    };
+}
+
+TEST(correctness, big_integer_view) {
+    const temp_file file;
+    const std::string &path = file.path;
+    const big_integer a = -pow(big_integer(3), 400000);  //  около 80 КиБ разрядов
+    big_integer_view::save(path, a);
+    {
+        pool_resource pool;
+        memory_resource *previous = set_default_resource(&pool);
+        {
+            big_integer_view view(path);
+            EXPECT_LT(pool.get_statistics().bytes_in_use, 1024u);  //  разряды не скопированы в кучу
+            EXPECT_EQ(0, compare(a, view));
+            EXPECT_TRUE(view.value() < 0);
+            EXPECT_EQ(a * 2, a + view);
+            EXPECT_EQ(0, a - view);
+            EXPECT_EQ(1, a / view);
+            EXPECT_EQ(0, a % view);
+            EXPECT_EQ(3, (a * 3 - 5) / view);
+            EXPECT_EQ(-5, (a * 3 - 5) % view);
+            EXPECT_EQ(-a, view * -1);
+        }
+        set_default_resource(previous);
+    }
+    {
+        std::ifstream in(path, std::ios::binary);
+        const std::vector<uint8_t> expected = serialize(a);
+        EXPECT_EQ(expected, std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+    }
+    big_integer_view::save(path, big_integer(-123456789));
+    {
+        big_integer_view view(path);
+        EXPECT_EQ("-123456789", to_string(view));
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "garbage";
+    }
+    EXPECT_THROW(big_integer_view view(path), std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(big_integer_view view(path), std::runtime_error);
+}
+
+TEST(correctness, radix) {
+    EXPECT_EQ("ff", to_string(big_integer(255), 16));
+    EXPECT_EQ("-777", to_string(big_integer(-511), 8));
+    EXPECT_EQ("-100000000000000000000000000000000", to_string(-(big_integer(1) << 32), 2));
+    EXPECT_EQ("zz", to_string(big_integer(36 * 36 - 1), 36));
+    EXPECT_EQ("0", to_string(big_integer(0), 7));
+    EXPECT_EQ(big_integer(48879), big_integer("BeEf", 16));
+    EXPECT_EQ(big_integer(-8), big_integer("-1000", 2));
+    EXPECT_EQ(0, big_integer("-000", 3));
+    EXPECT_EQ(pow(big_integer(3), 100), big_integer("1" + std::string(100, '0'), 3));
+    EXPECT_THROW(big_integer("12", 37), std::runtime_error);
+    EXPECT_THROW(big_integer("19", 8), std::runtime_error);
+    EXPECT_THROW(big_integer("-", 10), std::runtime_error);
+    EXPECT_THROW(big_integer("1-2"), std::runtime_error);
+    EXPECT_THROW(to_string(big_integer(5), 1), std::runtime_error);
+}
+
+TEST(correctness_random, radix) {
+    std::mt19937 rng(40);
+    for (int bits : {1, 31, 32, 33, 64, 100, 1000, 20000}) {
+        big_integer_gmp g;
+        g.random(bits, rng);
+        if (bits % 2 == 1) {
+            g = -g;
+        }
+        const std::string decimal = to_string(g);
+        const big_integer a(decimal);
+        EXPECT_EQ(decimal, to_string(a));
+        for (uint32_t base = 2; base <= 36; ++base) {
+            const std::string str = to_string(a, base);
+            EXPECT_EQ(a, big_integer(str, base));
+            if (a != 0) {
+                EXPECT_NE('0', str[str[0] == '-']);
+            }
+        }
+    }
+}
+
+TEST(correctness_random, to_string_divide_and_conquer) {
+    std::mt19937 rng(41);
+    for (int bits : {5000, 60000, 300000}) {  //  Newton reciprocals above 64 limbs, several levels of recursion
+        big_integer_gmp g;
+        g.random(bits, rng);
+        EXPECT_EQ(to_string(g), to_string(big_integer(to_string(g))));
+    }
+    for (int e : {576, 1152, 2304, 4608, 9216}) {  //  powers of 10^9 used as divisors, their neighbours and squares
+        const big_integer p = pow(big_integer(10), e);
+        EXPECT_EQ("1" + std::string(e, '0'), to_string(p));
+        EXPECT_EQ(std::string(e, '9'), to_string(p - 1));
+        EXPECT_EQ("1" + std::string(e - 1, '0') + "1", to_string(p + 1));
+        EXPECT_EQ(std::string(2 * e, '9'), to_string(p * p - 1));
+        EXPECT_EQ("1" + std::string(2 * e, '0'), to_string(p * p));
+    }
+}
+
+TEST(correctness, stream_io) {
+    std::istringstream in("  -123 +45 0x 77\n000999");
+    big_integer a, b, c, d;
+    in >> a >> b >> c;
+    EXPECT_EQ(-123, a);
+    EXPECT_EQ(45, b);
+    EXPECT_EQ(0, c);
+    EXPECT_FALSE(in >> d);  //  "x" - не цифра
+    in.clear();
+    in.ignore();
+    in >> std::hex >> d;
+    EXPECT_EQ(0x77, d);
+    in >> std::dec >> d;
+    EXPECT_EQ(999, d);
+    EXPECT_TRUE(in.eof());
+
+    std::ostringstream out;
+    out << big_integer(-255) << ' ' << std::hex << big_integer(-255) << ' ' << std::oct << big_integer(8) << std::dec;
+    out << '|' << std::setw(6) << big_integer(42) << '|' << big_integer(0);
+    EXPECT_EQ("-255 -ff 10|    42|0", out.str());
+}
+
+TEST(correctness, stream_input_lone_sign) {
+    std::istringstream in("- 5");
+    big_integer a = 7;
+    EXPECT_FALSE(in >> a);
+    EXPECT_EQ(7, a);
+    in.clear();
+    EXPECT_EQ('-', in.get());  //  знак остался в потоке
+    EXPECT_TRUE(static_cast<bool>(in >> a));
+    EXPECT_EQ(5, a);
+
+    std::istringstream sign_only("+");
+    EXPECT_FALSE(sign_only >> a);
+    EXPECT_TRUE(sign_only.eof());
+    sign_only.clear();
+    EXPECT_EQ('+', sign_only.get());
+
+    std::istringstream hex("-g");
+    EXPECT_FALSE(hex >> std::hex >> a);
+    hex.clear();
+    EXPECT_EQ('-', hex.get());
+}
+
+TEST(correctness_random, stream_io) {
+    std::mt19937 rng(41);
+    for (int bits : {1, 64, 1000, 20000, 300000}) {
+        big_integer_gmp g;
+        g.random(bits, rng);
+        if (bits % 2 == 0) {
+            g = -g;
+        }
+        const std::string str = to_string(g);
+        big_integer a;
+        std::istringstream in(str + " 7");
+        in >> a;
+        EXPECT_EQ(big_integer(str), a);
+        std::ostringstream out;
+        out << a << ' ' << std::hex << a;
+        EXPECT_EQ(str + ' ' + to_string(a, 16), out.str());
+    }
+}
+
+TEST(correctness, storage_stats) {
+    big_integer a(1);
+    a <<= 2048;
+    storage_stats::reset();
+    big_integer b = a;
+    b += 1;  //  shared buffer must be copied before the write
+    big_integer c(3);
+    c <<= 4096;  //  static storage is promoted to the heap
+    const storage_stats::snapshot s = storage_stats::get();
+    if (storage_stats::ENABLED) {
+        EXPECT_EQ(1u, s.deep_copies);
+        EXPECT_GE(s.promotions, 1u);
+        EXPECT_GE(s.heap_allocations, 2u);
+        EXPECT_GE(s.bytes_copied, 2048u / 8);
+        EXPECT_GE(s.peak_limbs, s.limbs_in_use);
+    } else {
+        EXPECT_EQ(0u, s.deep_copies);
+        EXPECT_EQ(0u, s.heap_allocations);
+    }
+    EXPECT_EQ(a + 1, b);
+}
+
+TEST(correctness, operation_trace) {
+    big_integer a(1), b(3);
+    a <<= 1000;
+    operation_trace::reset();
+    a *= b;
+    a += b;  //  int64 fast path is not taken, but it's still one call
+    b += 1;
+    EXPECT_EQ(-1, big_integer(-2) >> 1);
+    const std::vector<operation_trace::histogram> h = operation_trace::collect();
+    ASSERT_EQ(static_cast<size_t>(operation_trace::OPERATIONS), h.size());
+    if (operation_trace::ENABLED) {
+        EXPECT_EQ(1u, h[operation_trace::MUL].calls);
+        EXPECT_EQ(2u, h[operation_trace::ADD].calls);
+        EXPECT_EQ(1u, h[operation_trace::SHIFT].calls);
+        EXPECT_EQ(1u, h[operation_trace::MUL].sizes[operation_trace::bucket(32, operation_trace::SIZE_BUCKETS)]);
+        EXPECT_EQ(0u, h[operation_trace::DIV].calls);
+    } else {
+        EXPECT_EQ(0u, h[operation_trace::MUL].calls);
+    }
+}
+
+TEST(correctness_random, mul_unbalanced) {
+    std::default_random_engine rng(46);
+    for (size_t short_bits : {20, 40, 64, 90, 128, 1500, 1600, 3000, 5000}) {
+        for (size_t long_bits : {3000, 50000}) {
+            big_integer_gmp a, b;
+            a.random(long_bits, rng);
+            b.random(short_bits, rng);
+            big_integer A = big_integer(to_string(a)), B = big_integer(to_string(b));
+            EXPECT_EQ(to_string(a * b), to_string(A * B));
+            EXPECT_EQ(to_string(b * a), to_string(B * A));
+        }
+    }
+    big_integer all_ones = (big_integer(1) << 100000) - 1, two_limbs = (big_integer(1) << 64) - 1;
+    EXPECT_EQ((all_ones << 64) - all_ones, all_ones * two_limbs);
+    big_integer a = pow(big_integer(myrand()), 8000) + 1, b = pow(big_integer(myrand()), 1100) - 1;
+    big_integer expected = a * b;
+    for (size_t threads : {2, 4}) {
+        big_integer::set_thread_count(threads);
+        EXPECT_EQ(expected, a * b);
+        EXPECT_EQ(expected, b * a);
+    }
+    big_integer::set_thread_count(1);
+    EXPECT_EQ(expected, (a >> 100000) * b * (big_integer(1) << 100000) + (a & ((big_integer(1) << 100000) - 1)) * b);
+}
+
+TEST(correctness_random, mul_basecase) {
+    std::default_random_engine rng(47);
+    for (size_t n = 1; n <= 50; n += 1 + n / 8) {
+        for (size_t m = 1; m <= n + 3; ++m) {  //  every parity of lengths, on both sides of the Karatsuba threshold
+            big_integer_gmp a, b;
+            a.random(32 * n - 1, rng);
+            b.random(32 * m - 1, rng);
+            EXPECT_EQ(to_string(a * b), to_string(big_integer(to_string(a)) * big_integer(to_string(b))));
+        }
+    }
+    big_integer even = big_integer(1) << 32 * 46, odd = big_integer(1) << 32 * 45;  //  B^k - 1 has all limbs maximal
+    EXPECT_EQ(even * even - 2 * even + 1, (even - 1) * (even - 1));
+    EXPECT_EQ(even * odd - even - odd + 1, (even - 1) * (odd - 1));
+    EXPECT_EQ(odd * odd - 2 * odd + 1, (odd - 1) * (odd - 1));
+}
+
+TEST(correctness, divexact) {
+    EXPECT_EQ(0, divexact(0, 7));
+    EXPECT_EQ(-6, divexact(42, -7));
+    EXPECT_EQ(6, divexact(-42, -7));
+    EXPECT_EQ(big_integer(1) << 200, divexact(big_integer(1) << 300, big_integer(1) << 100));
+    EXPECT_EQ(-3, divexact(-(big_integer(3) << 100), big_integer(1) << 100));
+    big_integer f = 1;
+    for (int i = 1; i <= 300; ++i) {
+        f *= i;
+    }
+    big_integer g = f;
+    for (int i = 300; i >= 1; --i) {
+        g = divexact(g, i);
+    }
+    EXPECT_EQ(1, g);
+    EXPECT_EQ(big_integer(1) << 5000, divexact(pow(big_integer(6), 5000), pow(big_integer(3), 5000)));
+    EXPECT_THROW(divexact(1, 0), std::runtime_error);
+}
+
+TEST(correctness_random, divexact) {
+    std::default_random_engine rng(48);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer_gmp q, d;
+        q.random(rng() % 3000 + 1, rng);
+        d.random(rng() % 3000 + 1, rng);
+        if (d == 0) {
+            continue;
+        }
+        d *= big_integer_gmp(1) << static_cast<int>(rng() % 70);
+        big_integer Q(to_string(q)), D(to_string(d));
+        EXPECT_EQ(Q, divexact(Q * D, D));
+        EXPECT_EQ(to_string(q * d / d), to_string(divexact(Q * D, D)));
+    }
+    for (size_t bits : {7000, 20000, 60000}) {  //  quotients longer than the schoolbook threshold
+        big_integer_gmp q, d;
+        q.random(bits, rng);
+        d.random(bits / 3, rng);
+        big_integer Q(to_string(q)), D(to_string(d));
+        EXPECT_EQ(Q, divexact(Q * D, D));
+        EXPECT_EQ(-Q, divexact(Q * D << 37, -(D << 37)));
+        EXPECT_EQ(D, divexact(Q * D, Q));
+    }
+}
+
+TEST(correctness, small_divisor) {
+    for (uint32_t d : {1u, 2u, 3u, 10u, 1000000000u, 1000000007u, 0x80000000u, UINT32_MAX}) {
+        const small_divisor divisor(d);
+        EXPECT_EQ(d, divisor.value());
+        for (const big_integer &a : {big_integer(0), big_integer(d), big_integer(d) - 1, pow(big_integer(d), 7),
+                                     pow(big_integer(d), 7) - 1, (big_integer(1) << 1000) - 1}) {
+            EXPECT_EQ(a / big_integer(d), a / divisor);
+            EXPECT_EQ(a % big_integer(d), a % divisor);
+            EXPECT_EQ(-a / big_integer(d), -a / divisor);
+            EXPECT_EQ(-a % big_integer(d), -a % divisor);
+        }
+    }
+    big_integer a = -7;
+    a /= small_divisor(10);
+    EXPECT_EQ(0, a);
+    EXPECT_EQ("0", to_string(a));
+    a = -7;
+    a %= small_divisor(7);
+    EXPECT_EQ("0", to_string(a));
+    EXPECT_THROW(small_divisor(0), std::runtime_error);
+}
+
+TEST(correctness_random, small_divisor) {
+    std::default_random_engine rng(49);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer_gmp a;
+        a.random(rng() % 5000 + 1, rng);
+        const uint32_t d = static_cast<uint32_t>(rng()) >> (rng() % 32) | 1u;  //  every normalization shift
+        const big_integer_gmp g(std::to_string(d));
+        const small_divisor divisor(d);
+        big_integer A(to_string(a));
+        EXPECT_EQ(to_string(a / g), to_string(A / divisor));
+        EXPECT_EQ(to_string(a % g), to_string(A % divisor));
+        EXPECT_EQ(to_string(-a / g), to_string(-A / divisor));
+        EXPECT_EQ(to_string(-a % g), to_string(-A % divisor));
+        EXPECT_EQ(to_string(a / g), to_string(A / d));
+        EXPECT_EQ(to_string(a % g), to_string(A % d));
+    }
+}
+
+TEST(correctness, bit_operations) {
+    EXPECT_EQ(0u, big_integer(0).bit_length());
+    EXPECT_EQ(0u, big_integer(-1).bit_length());
+    EXPECT_EQ(3u, big_integer(7).bit_length());
+    EXPECT_EQ(3u, big_integer(-8).bit_length());
+    EXPECT_EQ(4u, big_integer(-9).bit_length());
+    EXPECT_EQ(65u, (big_integer(1) << 64).bit_length());
+    EXPECT_EQ(64u, (-(big_integer(1) << 64)).bit_length());
+
+    EXPECT_EQ(0u, big_integer(0).popcount());
+    EXPECT_EQ(0u, big_integer(-1).popcount());
+    EXPECT_EQ(3u, big_integer(7).popcount());
+    EXPECT_EQ(3u, big_integer(-8).popcount());  //  ...11000
+    EXPECT_EQ(96u, (-(big_integer(1) << 96)).popcount());
+
+    EXPECT_EQ(0u, big_integer(0).trailing_zeros());
+    EXPECT_EQ(3u, big_integer(-8).trailing_zeros());
+    EXPECT_EQ(100u, (big_integer(5) << 100).trailing_zeros());
+
+    const big_integer x = -(big_integer(1) << 64);  //  ...1 1 0{64}
+    EXPECT_FALSE(x.test_bit(0));
+    EXPECT_FALSE(x.test_bit(63));
+    EXPECT_TRUE(x.test_bit(64));
+    EXPECT_TRUE(x.test_bit(1000));
+    EXPECT_FALSE(big_integer(5).test_bit(1000));
+    EXPECT_TRUE(big_integer(-6).test_bit(1));  //  ...1010
+    EXPECT_FALSE(big_integer(-6).test_bit(0));
+    EXPECT_FALSE(big_integer(-6).test_bit(2));
+
+    big_integer a = 0;
+    EXPECT_EQ(big_integer(1) << 200, a.set_bit(200));
+    EXPECT_EQ(0, a.set_bit(200, false));
+    EXPECT_EQ("0", to_string(a));
+    big_integer b = -1;
+    EXPECT_EQ(-1 - (big_integer(1) << 100), b.set_bit(100, false));
+    EXPECT_EQ(-1, b.set_bit(100));
+    big_integer c = -6;
+    EXPECT_EQ(-5, c.set_bit(0));
+    EXPECT_EQ(-7, c.set_bit(1, false));
+    EXPECT_EQ(-7, c.set_bit(1, false));
+}
+
+TEST(correctness_random, bit_operations) {
+    std::default_random_engine rng(50);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer_gmp g;
+        g.random(rng() % 3000 + 1, rng);
+        big_integer a(to_string(g));
+        if (rng() % 2 == 0) {
+            a <<= static_cast<int>(rng() % 100);
+        }
+        for (const big_integer &x : {a, -a, a - 1, -a - 1}) {
+            size_t bits = 0, ones = 0;
+            for (size_t k = 0; k < 3200; ++k) {
+                if (x.test_bit(k) != (x < 0)) {
+                    bits = k + 1;
+                    ++ones;
+                }
+            }
+            for (size_t k = 0; k < 3200; k += 1 + rng() % 64) {
+                const bool bit = ((x >> static_cast<int>(k)) & 1) == 1;  //  the emulation the API replaces
+                EXPECT_EQ(bit, x.test_bit(k));
+                big_integer y = x;
+                EXPECT_EQ(bit ? x : x + (big_integer(1) << static_cast<int>(k)), y.set_bit(k));
+                y = x;
+                EXPECT_EQ(bit ? x - (big_integer(1) << static_cast<int>(k)) : x, y.set_bit(k, false));
+            }
+            EXPECT_EQ(bits, x.bit_length());
+            EXPECT_EQ(ones, x.popcount());
+            if (x != 0) {
+                EXPECT_EQ(x, (x >> static_cast<int>(x.trailing_zeros())) << static_cast<int>(x.trailing_zeros()));
+                EXPECT_TRUE(x.test_bit(x.trailing_zeros()));
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include "big_integer_view.h"
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    struct file_descriptor {
+        int fd;
+
+        ~file_descriptor() {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    };
+}
+
+big_integer_view::big_integer_view(const std::string &path) : mapping(nullptr), length(0) {
+    file_descriptor file{open(path.c_str(), O_RDONLY)};
+    struct stat info{};
+    if (file.fd < 0 || fstat(file.fd, &info) != 0) {
+        throw std::runtime_error("Can't open " + path);
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0) {
+        throw std::runtime_error("Empty file " + path);
+    }
+    mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Can't map " + path);
+    }
+    madvise(mapping, length, MADV_SEQUENTIAL);  ///  kernels scan limbs in order, pages behind can be dropped
+    try {
+        number = deserialize_view(mapping, length);  ///  mapping is page-aligned, so limbs are aligned too
+    } catch (...) {
+        munmap(mapping, length);
+        throw;
+    }
+}
+
+big_integer_view::~big_integer_view() {
+    number = 0;  ///  releases the view of the mapping before unmapping
+    munmap(mapping, length);
+}
+
+const big_integer &big_integer_view::value() const {
+    return number;
+}
+
+big_integer_view::operator const big_integer &() const {
+    return number;
+}
+
+void big_integer_view::save(const std::string &path, const big_integer &a) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    serialize(a, out);
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Can't write " + path);
+    }
+}
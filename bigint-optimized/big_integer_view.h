@@ -0,0 +1,38 @@
+#include "big_integer.h"
+#include <cstddef>
+#include <string>
+
+#ifndef BIGINT_BIG_INTEGER_VIEW_H
+#define BIGINT_BIG_INTEGER_VIEW_H
+
+///  Read-only number stored in a file in the format of serialize(): the file is mapped into memory and
+///  limbs are read straight from the page cache, so the number never occupies heap or anonymous memory.
+///  As an operand of arithmetic, comparisons and / or % the limbs are read in place; the exception is
+///  divexact by an even view, which shifts the divisor into the thread's scratch arena.
+///  value() and its copies reference the mapping and must not outlive the view; modified copies own their limbs.
+struct big_integer_view {
+    ///  @variables
+private:
+    void *mapping;
+    size_t length;
+    big_integer number;
+
+    ///  @methods
+public:
+    explicit big_integer_view(const std::string &path);  ///  throws std::runtime_error if file can't be mapped or is invalid
+
+    big_integer_view(const big_integer_view &) = delete;
+
+    big_integer_view &operator=(const big_integer_view &) = delete;
+
+    ~big_integer_view();
+
+    const big_integer &value() const;
+
+    operator const big_integer &() const;  ///  to be used in comparisons, to_string and as right operand of arithmetic
+
+    ///  writes a in the format read by the view, streaming the limbs without a copy of the whole serialization
+    static void save(const std::string &path, const big_integer &a);
+};
+
+#endif //BIGINT_BIG_INTEGER_VIEW_H
@@ -0,0 +1,54 @@
+#include "memory_resource.h"
+#include <cassert>
+#include <new>
+
+constexpr size_t memory_resource::DEFAULT_ALIGNMENT;
+
+namespace {
+    struct new_delete_memory_resource : memory_resource {
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override {
+            assert(alignment <= DEFAULT_ALIGNMENT);
+            return ::operator new(bytes);
+        }
+
+        void do_deallocate(void *p, size_t, size_t) override {
+            ::operator delete(p);
+        }
+    };
+
+    thread_local memory_resource *default_resource = nullptr;
+}
+
+memory_resource::~memory_resource() = default;
+
+void *memory_resource::allocate(size_t bytes, size_t alignment) {
+    return do_allocate(bytes, alignment);
+}
+
+void memory_resource::deallocate(void *p, size_t bytes, size_t alignment) {
+    do_deallocate(p, bytes, alignment);
+}
+
+bool memory_resource::is_equal(const memory_resource &other) const noexcept {
+    return do_is_equal(other);
+}
+
+bool memory_resource::do_is_equal(const memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+memory_resource *new_delete_resource() noexcept {
+    static new_delete_memory_resource resource;
+    return &resource;
+}
+
+memory_resource *get_default_resource() noexcept {
+    return default_resource ? default_resource : new_delete_resource();
+}
+
+memory_resource *set_default_resource(memory_resource *r) noexcept {
+    memory_resource *previous = get_default_resource();
+    default_resource = r;
+    return previous;
+}
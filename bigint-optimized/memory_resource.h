@@ -0,0 +1,80 @@
+#include <cstddef>
+#include <cstdint>
+
+#ifndef BIGINT_MEMORY_RESOURCE_H
+#define BIGINT_MEMORY_RESOURCE_H
+
+///  Polymorphic source of memory for heap storage of big_integer, a C++11 analogue of std::pmr::memory_resource
+struct memory_resource {
+    ///  @consts
+public:
+    static constexpr size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+    ///  @methods
+public:
+    virtual ~memory_resource();
+
+    void *allocate(size_t bytes, size_t alignment = DEFAULT_ALIGNMENT);
+
+    void deallocate(void *p, size_t bytes, size_t alignment = DEFAULT_ALIGNMENT);
+
+    bool is_equal(const memory_resource &other) const noexcept;
+
+private:
+    virtual void *do_allocate(size_t bytes, size_t alignment) = 0;
+
+    virtual void do_deallocate(void *p, size_t bytes, size_t alignment) = 0;
+
+    virtual bool do_is_equal(const memory_resource &other) const noexcept;
+};
+
+memory_resource *new_delete_resource() noexcept;  ///  ::operator new and ::operator delete
+
+memory_resource *get_default_resource() noexcept;  ///  resource used by new numbers of the current thread
+
+memory_resource *set_default_resource(memory_resource *r) noexcept;  ///  nullptr resets to new_delete_resource(), returns previous
+
+///  Allocator for standard containers that forwards to a memory_resource
+template<typename T>
+struct resource_allocator {
+    ///  @typedefs
+public:
+    using value_type = T;
+
+    ///  @variables
+private:
+    memory_resource *resource_;
+
+    ///  @methods
+public:
+    resource_allocator() noexcept : resource_(get_default_resource()) {}
+
+    resource_allocator(memory_resource *r) noexcept : resource_(r) {}
+
+    template<typename U>
+    resource_allocator(const resource_allocator<U> &other) noexcept : resource_(other.resource()) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    memory_resource *resource() const noexcept {
+        return resource_;
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const resource_allocator<T> &a, const resource_allocator<U> &b) noexcept {
+    return a.resource()->is_equal(*b.resource());
+}
+
+template<typename T, typename U>
+bool operator!=(const resource_allocator<T> &a, const resource_allocator<U> &b) noexcept {
+    return !(a == b);
+}
+
+#endif //BIGINT_MEMORY_RESOURCE_H
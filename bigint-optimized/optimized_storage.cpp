@@ -1,9 +1,56 @@
 #include "optimized_storage.h"
+#include "storage_stats.h"
 #include <cassert>
+#include <utility>
 
-optimized_storage::optimized_storage(size_t size, uint32_t val) {
+constexpr size_t optimized_storage::MAX_STATIC_SIZE;
+
+namespace {
+    const size_t SIGN_BIT = 1u;
+    const size_t SMALL_BIT = 2u;
+    const size_t SIZE_SHIFT = 2u;
+
+    const uint64_t HASH_PRIME_1 = 0x9e3779b185ebca87ull;
+    const uint64_t HASH_PRIME_2 = 0xc2b2ae3d27d4eb4full;
+    const size_t HASH_LANES = 4;  ///  independent accumulators, so that the compiler can vectorize the main loop
+
+    uint64_t rotl(uint64_t x, unsigned r) {
+        return (x << r) | (x >> (64u - r));
+    }
+
+    uint64_t hash_round(uint64_t acc, uint64_t input) {
+        return rotl(acc + input * HASH_PRIME_2, 31) * HASH_PRIME_1;
+    }
+
+    ///  xxhash-like: 64-bit words (pairs of limbs) are spread over lanes, then lanes are merged and avalanched
+    size_t hash_limbs(const uint32_t *a, size_t n) {
+        uint64_t lanes[HASH_LANES] = {HASH_PRIME_1, HASH_PRIME_2, 0, ~HASH_PRIME_1};
+        size_t i = 0;
+        for (; i + 2 * HASH_LANES <= n; i += 2 * HASH_LANES) {
+            for (size_t j = 0; j < HASH_LANES; ++j) {
+                const uint64_t word = (static_cast<uint64_t>(a[i + 2 * j + 1]) << 32u) | a[i + 2 * j];
+                lanes[j] = hash_round(lanes[j], word);
+            }
+        }
+        uint64_t h = n * HASH_PRIME_1;
+        for (size_t j = 0; j < HASH_LANES; ++j) {
+            h = hash_round(h, lanes[j]);
+        }
+        for (; i < n; ++i) {
+            h = hash_round(h, a[i]);
+        }
+        h ^= h >> 33u;
+        h *= HASH_PRIME_2;
+        h ^= h >> 29u;
+        h *= HASH_PRIME_1;
+        h ^= h >> 32u;
+        return static_cast<size_t>(h);
+    }
+}
+
+optimized_storage::optimized_storage(size_t size, uint32_t val) : meta(0) {
     if (size > MAX_STATIC_SIZE) {
-        ptr = new shared_vector(size, val);
+        ptr = shared_vector::create(size, val);
     } else {
         std::fill(static_data.begin(), static_data.begin() + size, val);
         std::fill(static_data.begin() + size, static_data.end(), 0);
@@ -11,23 +58,21 @@ optimized_storage::optimized_storage(size_t size, uint32_t val) {
     set_size(size);
 }
 
-optimized_storage::optimized_storage(const optimized_storage &other) {
-    if (other.small) {
+optimized_storage::optimized_storage(const optimized_storage &other) : meta(other.meta) {
+    if (other.is_small()) {
         static_data = other.static_data;
-    } else if (other.size_ <= MAX_STATIC_SIZE) {
+    } else if (other.size() <= MAX_STATIC_SIZE) {
         fill_static_from_other_dynamic(other);
     } else {
         ptr = other.ptr;
         ++ptr->ref_count;
     }
-    set_size(other.size_);
+    set_size(other.size());
 }
 
 optimized_storage::~optimized_storage() {
-    if (!small && ptr->ref_count == 1) {
-        delete ptr;
-    } else if (!small) {
-        --ptr->ref_count;
+    if (!is_small()) {
+        release();
     }
 }
 
@@ -40,23 +85,32 @@ optimized_storage &optimized_storage::operator=(const optimized_storage &other)
 }
 
 const uint32_t &optimized_storage::operator[](size_t i) const {
-    return small ? static_data[i] : ptr->data[i];
+    return is_small() ? static_data[i] : ptr->limbs()[i];
 }
 
 uint32_t &optimized_storage::operator[](size_t i) {
     make_unshared();
-    return small ? static_data[i] : ptr->data[i];
+    return is_small() ? static_data[i] : ptr->data[i];
 }
 
 size_t optimized_storage::size() const {
-    return size_;
+    return meta >> SIZE_SHIFT;
+}
+
+const uint32_t *optimized_storage::data() const {
+    return is_small() ? static_data.data() : ptr->limbs();
+}
+
+uint32_t *optimized_storage::data() {
+    make_unshared();
+    return is_small() ? static_data.data() : ptr->data.data();
 }
 
 bool operator==(const optimized_storage &a, const optimized_storage &b) {
-    if (a.size_ != b.size_) {
+    if (a.size() != b.size()) {
         return false;
     }
-    for (size_t i = 0; i < a.size_; ++i) {
+    for (size_t i = 0; i < a.size(); ++i) {
         if (a[i] != b[i]) {
             return false;
         }
@@ -64,61 +118,166 @@ bool operator==(const optimized_storage &a, const optimized_storage &b) {
     return true;
 }
 
+size_t optimized_storage::hash() const {
+    if (is_small()) {
+        return hash_limbs(static_data.data(), size());
+    }
+    size_t h = ptr->hash.load(std::memory_order_relaxed);
+    if (h == 0) {
+        h = hash_limbs(ptr->limbs(), size());
+        ptr->hash.store(h, std::memory_order_relaxed);
+    }
+    return h;
+}
+
 uint32_t optimized_storage::back() const {
-    return small ? static_data[size_ - 1] : ptr->data[size_ - 1];
+    return is_small() ? static_data[size() - 1] : ptr->limbs()[size() - 1];
 }
 
 void optimized_storage::pop_back() {
-    if (small) {
-        static_data[--size_] = 0;
+    const size_t n = size();
+    if (is_small()) {
+        static_data[n - 1] = 0;
     } else {
         make_unshared();
         ptr->data.pop_back();
-        --size_;
     }
+    store_size(n - 1);
 }
 
 void optimized_storage::push_back(uint32_t x) {
-    if (small && size_ + 1 <= MAX_STATIC_SIZE) {
-        static_data[size_] = x;
+    const size_t n = size();
+    if (is_small() && n + 1 <= MAX_STATIC_SIZE) {
+        static_data[n] = x;
     } else {
-        if (small) {  ///  converts from static storage to dynamic, after insertions size will be > MAX_STATIC_SIZE
-            std::vector<uint32_t> tmp(static_data.begin(), static_data.begin() + size_);
-            ptr = new shared_vector(tmp);
-            small = false;
+        if (is_small()) {  ///  converts from static storage to dynamic, after insertions size will be > MAX_STATIC_SIZE
+            ptr = shared_vector::create(static_data.data(), static_data.data() + n, n + 1);
+            set_small(false);
+            storage_stats::count_promotion(n);
         } else {
             make_unshared();
         }
+        const size_t capacity = ptr->data.capacity();
         ptr->data.push_back(x);
+        storage_stats::count_resize(capacity, ptr->data.capacity());
+    }
+    store_size(n + 1);
+}
+
+void optimized_storage::reserve(size_t capacity) {
+    if (capacity <= MAX_STATIC_SIZE) {
+        return;
+    }
+    if (is_small()) {
+        ptr = shared_vector::create(static_data.data(), static_data.data() + size(), capacity);
+        set_small(false);
+        storage_stats::count_promotion(size());
+    } else {
+        make_unshared();
+        const size_t old_capacity = ptr->data.capacity();
+        ptr->data.reserve(capacity);
+        storage_stats::count_resize(old_capacity, ptr->data.capacity());
     }
-    ++size_;
+}
+
+void optimized_storage::assign(size_t size, uint32_t val) {
+    if (is_small() && size <= MAX_STATIC_SIZE) {
+        std::fill(static_data.begin(), static_data.begin() + size, val);
+        std::fill(static_data.begin() + size, static_data.end(), 0);
+    } else if (is_small()) {
+        ptr = shared_vector::create(size, val);
+        set_small(false);
+        storage_stats::count_promotion(0);
+    } else if (ptr->ref_count != 1 || ptr->is_view()) {  ///  old data will be overwritten, so there is no need to copy it
+        release();
+        if (size <= MAX_STATIC_SIZE) {
+            std::fill(static_data.begin(), static_data.begin() + size, val);
+            std::fill(static_data.begin() + size, static_data.end(), 0);
+            set_small(true);
+            storage_stats::count_demotion(0);
+        } else {
+            ptr = shared_vector::create(size, val);
+        }
+    } else {
+        const size_t capacity = ptr->data.capacity();
+        ptr->data.assign(size, val);
+        ptr->hash.store(0, std::memory_order_relaxed);
+        storage_stats::count_resize(capacity, ptr->data.capacity());
+    }
+    store_size(size);
+}
+
+bool optimized_storage::sign() const {
+    return (meta & SIGN_BIT) != 0;
+}
+
+void optimized_storage::set_sign(bool sign) {
+    meta = sign ? (meta | SIGN_BIT) : (meta & ~SIGN_BIT);
+}
+
+bool optimized_storage::is_small() const {
+    return (meta & SMALL_BIT) != 0;
+}
+
+void optimized_storage::set_small(bool small) {
+    meta = small ? (meta | SMALL_BIT) : (meta & ~SMALL_BIT);
 }
 
 void optimized_storage::set_size(size_t new_size) {
-    size_ = new_size;
-    small = size_ <= MAX_STATIC_SIZE;
+    store_size(new_size);
+    set_small(new_size <= MAX_STATIC_SIZE);
+}
+
+void optimized_storage::store_size(size_t new_size) {
+    meta = (new_size << SIZE_SHIFT) | (meta & (SIGN_BIT | SMALL_BIT));
 }
 
 void optimized_storage::fill_static_from_other_dynamic(const optimized_storage &other) {
-    assert(other.size_ <= MAX_STATIC_SIZE);
-    std::copy(other.ptr->data.begin(), other.ptr->data.end(), static_data.begin());
-    std::fill(static_data.begin() + other.size_, static_data.end(), 0);
+    assert(other.size() <= MAX_STATIC_SIZE);
+    std::copy(other.ptr->limbs(), other.ptr->limbs() + other.size(), static_data.begin());
+    std::fill(static_data.begin() + other.size(), static_data.end(), 0);
+    storage_stats::count_demotion(other.size());
 }
 
-void optimized_storage::make_unshared() {
-    if (!small && ptr->ref_count != 1) {
-        auto *tmp = new shared_vector(*ptr);
+void optimized_storage::adopt(const uint32_t *limbs, const size_t size) {
+    if (size <= MAX_STATIC_SIZE) {
+        assign(size, 0);  ///  a view is not worth a heap node for a few limbs
+        std::copy(limbs, limbs + size, data());
+        return;
+    }
+    shared_vector *view = shared_vector::create_view(limbs, size);
+    if (!is_small()) {
+        release();
+    }
+    ptr = view;
+    set_size(size);
+}
+
+void optimized_storage::release() {
+    if (ptr->ref_count == 1) {
+        shared_vector::destroy(ptr);
+    } else {
         --ptr->ref_count;
+    }
+}
+
+void optimized_storage::make_unshared() {
+    if (!is_small() && (ptr->ref_count != 1 || ptr->is_view())) {
+        auto *tmp = shared_vector::create(*ptr);
+        storage_stats::count_deep_copy(size());
+        release();
         ptr = tmp;
+    } else if (!is_small()) {
+        ptr->hash.store(0, std::memory_order_relaxed);
     }
 }
 
 void optimized_storage::swap(optimized_storage &other) {
-    if (small && other.small) {
+    if (is_small() && other.is_small()) {
         std::swap(static_data, other.static_data);
-    } else if (!small && !other.small) {
+    } else if (!is_small() && !other.is_small()) {
         std::swap(ptr, other.ptr);
-    } else if (small && !other.small) {
+    } else if (is_small() && !other.is_small()) {
         auto tmp_ptr = other.ptr;
         other.static_data = static_data;
         ptr = tmp_ptr;
@@ -127,6 +286,5 @@ void optimized_storage::swap(optimized_storage &other) {
         static_data = other.static_data;
         other.ptr = tmp_ptr;
     }
-    std::swap(small, other.small);
-    std::swap(size_, other.size_);
+    std::swap(meta, other.meta);
 }
@@ -5,10 +5,15 @@
 #ifndef BIGINT_OPTIMIZED_STORAGE_H
 #define BIGINT_OPTIMIZED_STORAGE_H
 
+#ifndef BIGINT_INLINE_LIMBS
+#define BIGINT_INLINE_LIMBS 0  ///  requested static storage size, by default as many limbs as fit into a pointer
+#endif
+
 struct optimized_storage {
     /// @consts
-private:
-    static constexpr size_t MAX_STATIC_SIZE = sizeof(shared_vector *) / sizeof(uint32_t);  ///  optimal size
+public:
+    static constexpr size_t MAX_STATIC_SIZE = BIGINT_INLINE_LIMBS > sizeof(shared_vector *) / sizeof(uint32_t)
+            ? BIGINT_INLINE_LIMBS : sizeof(shared_vector *) / sizeof(uint32_t);  ///  optimal size is the default
 
     ///  @variables
 private:
@@ -17,9 +22,7 @@ private:
         std::array<uint32_t, MAX_STATIC_SIZE> static_data;  /// static storage
     };
 
-    size_t size_;  ///  number of "digits" in data
-
-    bool small;  ///  true, if data stores in static storage
+    size_t meta;  ///  size << 2 | small << 1 | sign, where small is true, if data stores in static storage
 
     ///  @methods
 public:
@@ -37,22 +40,48 @@ public:
 
     size_t size() const;
 
+    const uint32_t *data() const;
+
+    uint32_t *data();  ///  unshares data, pointer is valid until next modification of size
+
     friend bool operator==(const optimized_storage &a, const optimized_storage &b);
 
+    size_t hash() const;  ///  hash of limbs, cached in dynamic storage until the next modification
+
     uint32_t back() const;
 
     void pop_back();
 
     void push_back(uint32_t x);
 
+    void reserve(size_t capacity);  ///  preallocates dynamic storage, if capacity doesn't fit in static storage
+
+    void assign(size_t size, uint32_t val);  ///  like constructor, but reuses own unshared buffer
+
+    ///  read-only view of external limbs that must outlive it, copied on the first modification;
+    ///  small numbers are copied into static storage at once
+    void adopt(const uint32_t *limbs, size_t size);
+
+    void swap(optimized_storage &other);
+
+    bool sign() const;  ///  sign of the number, stored here to share a word with size
+
+    void set_sign(bool sign);
+
 private:
-    void set_size(size_t new_size);  ///  updates size_ and small
+    bool is_small() const;
+
+    void set_small(bool small);
+
+    void set_size(size_t new_size);  ///  updates size and small
+
+    void store_size(size_t new_size);  ///  updates only size
 
     void fill_static_from_other_dynamic(const optimized_storage &other);  /// trying to avoid allocating dynamic memory
 
-    void make_unshared();  ///  if *this shares data, then makes data unique
+    void release();  ///  drops reference to dynamic storage
 
-    void swap(optimized_storage &other);
+    void make_unshared();  ///  copies shared or viewed data to make it unique, drops cached hash before writing
 };
 
 bool operator==(const optimized_storage &a, const optimized_storage &b);
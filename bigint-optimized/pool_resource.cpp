@@ -0,0 +1,68 @@
+#include "pool_resource.h"
+#include <cassert>
+
+constexpr size_t pool_resource::MIN_CLASS_LOG;
+constexpr size_t pool_resource::MAX_CLASS_LOG;
+constexpr size_t pool_resource::MAX_POOLED_SIZE;
+constexpr size_t pool_resource::CHUNK_SIZE;
+
+pool_resource::pool_resource(memory_resource *upstream) : upstream(upstream), free_lists(), stats{0, 0, 0} {}
+
+pool_resource::~pool_resource() {
+    for (void *chunk : chunks) {
+        upstream->deallocate(chunk, CHUNK_SIZE);
+    }
+}
+
+const pool_resource::statistics &pool_resource::get_statistics() const {
+    return stats;
+}
+
+void *pool_resource::do_allocate(size_t bytes, size_t alignment) {
+    assert(alignment <= DEFAULT_ALIGNMENT);
+    if (bytes > MAX_POOLED_SIZE) {
+        ++stats.upstream_allocations;
+        return upstream->allocate(bytes, alignment);
+    }
+    const size_t index = class_index(bytes);
+    if (!free_lists[index]) {
+        refill(index);
+    }
+    free_block *block = free_lists[index];
+    free_lists[index] = block->next;
+    ++stats.allocations;
+    stats.bytes_in_use += static_cast<size_t>(1) << (index + MIN_CLASS_LOG);
+    return block;
+}
+
+void pool_resource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    if (bytes > MAX_POOLED_SIZE) {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+    const size_t index = class_index(bytes);
+    auto *block = static_cast<free_block *>(p);
+    block->next = free_lists[index];
+    free_lists[index] = block;
+    stats.bytes_in_use -= static_cast<size_t>(1) << (index + MIN_CLASS_LOG);
+}
+
+size_t pool_resource::class_index(size_t bytes) {
+    if (bytes <= (static_cast<size_t>(1) << MIN_CLASS_LOG)) {
+        return 0;
+    }
+    return static_cast<size_t>(64 - __builtin_clzll(bytes - 1)) - MIN_CLASS_LOG;
+}
+
+void pool_resource::refill(size_t index) {
+    const size_t block_size = static_cast<size_t>(1) << (index + MIN_CLASS_LOG);
+    chunks.reserve(chunks.size() + 1);
+    auto *chunk = static_cast<char *>(upstream->allocate(CHUNK_SIZE));
+    chunks.push_back(chunk);
+    ++stats.upstream_allocations;
+    for (size_t offset = CHUNK_SIZE; offset >= block_size; offset -= block_size) {
+        auto *block = reinterpret_cast<free_block *>(chunk + offset - block_size);
+        block->next = free_lists[index];
+        free_lists[index] = block;
+    }
+}
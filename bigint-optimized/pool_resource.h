@@ -0,0 +1,63 @@
+#include "memory_resource.h"
+#include <cstddef>
+#include <vector>
+
+#ifndef BIGINT_POOL_RESOURCE_H
+#define BIGINT_POOL_RESOURCE_H
+
+///  Size-class pool: requests up to MAX_POOLED_SIZE bytes are rounded up to a power of two
+///  and served from per-class free lists, chunks are taken from upstream and returned only
+///  in destructor. Larger requests go straight to upstream. Not synchronized: numbers that
+///  use the pool must be created and destroyed by one thread at a time.
+struct pool_resource : memory_resource {
+    ///  @typedefs
+public:
+    struct statistics {
+        size_t allocations;  ///  requests served by the pool
+        size_t upstream_allocations;  ///  chunks and large blocks requested from upstream
+        size_t bytes_in_use;  ///  rounded sizes of live pooled blocks
+    };
+
+    ///  @consts
+public:
+    static constexpr size_t MIN_CLASS_LOG = 4;  ///  16 bytes
+    static constexpr size_t MAX_CLASS_LOG = 16;  ///  64 KiB
+    static constexpr size_t MAX_POOLED_SIZE = static_cast<size_t>(1) << MAX_CLASS_LOG;
+
+private:
+    static constexpr size_t CHUNK_SIZE = static_cast<size_t>(1) << 18u;  ///  256 KiB, at least one block of any class
+
+    struct free_block {
+        free_block *next;
+    };
+
+    ///  @variables
+private:
+    memory_resource *upstream;
+    free_block *free_lists[MAX_CLASS_LOG - MIN_CLASS_LOG + 1];
+    std::vector<void *> chunks;
+    statistics stats;
+
+    ///  @methods
+public:
+    explicit pool_resource(memory_resource *upstream = new_delete_resource());
+
+    pool_resource(const pool_resource &) = delete;
+
+    pool_resource &operator=(const pool_resource &) = delete;
+
+    ~pool_resource() override;
+
+    const statistics &get_statistics() const;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    static size_t class_index(size_t bytes);
+
+    void refill(size_t index);  ///  splits a new chunk into free blocks of the class
+};
+
+#endif //BIGINT_POOL_RESOURCE_H
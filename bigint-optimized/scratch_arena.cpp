@@ -0,0 +1,63 @@
+#include "scratch_arena.h"
+#include <algorithm>
+#include <cassert>
+
+constexpr size_t scratch_arena::MIN_BLOCK_SIZE;
+
+scratch_arena::scratch_arena() : top{0, 0, 0}, stats{0, 0, 0, 0} {}
+
+scratch_arena &scratch_arena::local() {
+    static thread_local scratch_arena arena;
+    return arena;
+}
+
+uint32_t *scratch_arena::allocate(size_t n) {
+    while (top.block < blocks.size() && blocks[top.block].size - top.offset < n) {
+        ++top.block;
+        top.offset = 0;
+    }
+    if (top.block == blocks.size()) {
+        const size_t size = std::max({n, MIN_BLOCK_SIZE, blocks.empty() ? 0 : 2 * blocks.back().size});
+        blocks.push_back({std::unique_ptr<uint32_t[]>(new uint32_t[size]), size});
+        ++stats.blocks;
+    }
+    uint32_t *result = blocks[top.block].data.get() + top.offset;
+    top.offset += n;
+    top.in_use += n;
+    ++stats.requests;
+    stats.limbs += n;
+    stats.peak_limbs = std::max(stats.peak_limbs, top.in_use);
+    return result;
+}
+
+scratch_arena::position scratch_arena::mark() const {
+    return top;
+}
+
+void scratch_arena::release(const position &p) {
+    top = p;
+}
+
+void scratch_arena::trim() {
+    assert(top.in_use == 0);
+    blocks.clear();
+    top = {0, 0, 0};
+}
+
+const scratch_arena::statistics &scratch_arena::get_statistics() const {
+    return stats;
+}
+
+void scratch_arena::reset_statistics() {
+    stats = {0, 0, 0, top.in_use};
+}
+
+scratch_scope::scratch_scope() : arena(scratch_arena::local()), start(arena.mark()) {}
+
+scratch_scope::~scratch_scope() {
+    arena.release(start);
+}
+
+uint32_t *scratch_scope::allocate(size_t n) {
+    return arena.allocate(n);
+}
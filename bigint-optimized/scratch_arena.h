@@ -0,0 +1,87 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifndef BIGINT_SCRATCH_ARENA_H
+#define BIGINT_SCRATCH_ARENA_H
+
+///  Thread-local bump allocator for temporary limb buffers of arithmetic kernels.
+///  Memory is released in LIFO order by scratch_scope and blocks are kept for reuse,
+///  so after warm-up the temporaries of an operation cost no heap allocations.
+struct scratch_arena {
+    ///  @typedefs
+public:
+    struct statistics {
+        size_t requests;  ///  number of allocate() calls
+        size_t limbs;  ///  total number of limbs handed out
+        size_t blocks;  ///  number of heap allocations made by the arena
+        size_t peak_limbs;  ///  maximal number of limbs in use at once
+    };
+
+    struct position {
+        size_t block;
+        size_t offset;
+        size_t in_use;
+    };
+
+private:
+    struct block {
+        std::unique_ptr<uint32_t[]> data;
+        size_t size;
+    };
+
+    ///  @consts
+private:
+    static constexpr size_t MIN_BLOCK_SIZE = 1u << 12u;  ///  in limbs
+
+    ///  @variables
+private:
+    std::vector<block> blocks;
+    position top;
+    statistics stats;
+
+    ///  @methods
+public:
+    scratch_arena();
+
+    scratch_arena(const scratch_arena &) = delete;
+
+    scratch_arena &operator=(const scratch_arena &) = delete;
+
+    static scratch_arena &local();  ///  arena of the current thread
+
+    uint32_t *allocate(size_t n);  ///  uninitialized buffer of n limbs
+
+    position mark() const;
+
+    void release(const position &p);  ///  frees everything allocated after mark p
+
+    void trim();  ///  returns all blocks to the heap, pre: nothing is allocated
+
+    const statistics &get_statistics() const;
+
+    void reset_statistics();
+};
+
+///  Scratch memory of the current thread allocated while the scope is alive is released in destructor
+struct scratch_scope {
+    ///  @variables
+private:
+    scratch_arena &arena;
+    scratch_arena::position start;
+
+    ///  @methods
+public:
+    scratch_scope();
+
+    scratch_scope(const scratch_scope &) = delete;
+
+    scratch_scope &operator=(const scratch_scope &) = delete;
+
+    ~scratch_scope();
+
+    uint32_t *allocate(size_t n);
+};
+
+#endif //BIGINT_SCRATCH_ARENA_H
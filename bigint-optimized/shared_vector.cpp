@@ -1,10 +1,81 @@
 #include "shared_vector.h"
+#include "storage_stats.h"
+#include <new>
 #include <utility>
 #include <vector>
 #include <cstdint>
 
-shared_vector::shared_vector(const size_t size, const uint32_t val) : data(size, val), ref_count(1) {}
+shared_vector::shared_vector(const size_t size, const uint32_t val, memory_resource *resource)
+        : data(size, val, storage::allocator_type(resource)), view(nullptr), view_size(0), ref_count(1), hash(0) {}
 
-shared_vector::shared_vector(std::vector<uint32_t> other_data) : data(std::move(other_data)), ref_count(1) {}
+shared_vector::shared_vector(memory_resource *resource)
+        : data(storage::allocator_type(resource)), view(nullptr), view_size(0), ref_count(1), hash(0) {}
 
-shared_vector::shared_vector(const shared_vector &other) : data(other.data), ref_count(1) {}
+shared_vector::shared_vector(const shared_vector &other)
+        : data(other.limbs(), other.limbs() + (other.is_view() ? other.view_size : other.data.size()),
+               other.data.get_allocator()), view(nullptr), view_size(0), ref_count(1), hash(0) {}
+
+shared_vector::shared_vector(const uint32_t *first, const size_t size, memory_resource *resource)
+        : data(storage::allocator_type(resource)), view(first), view_size(size), ref_count(1), hash(0) {}
+
+template<typename... Args>
+shared_vector *shared_vector::allocate(memory_resource *resource, Args &&... args) {
+    void *memory = resource->allocate(sizeof(shared_vector), alignof(shared_vector));
+    try {
+        return new(memory) shared_vector(std::forward<Args>(args)...);
+    } catch (...) {
+        resource->deallocate(memory, sizeof(shared_vector), alignof(shared_vector));
+        throw;
+    }
+}
+
+shared_vector *shared_vector::create(const size_t size, const uint32_t val, memory_resource *resource) {
+    shared_vector *result = allocate(resource, size, val, resource);
+    storage_stats::count_allocation(result->data.capacity());
+    return result;
+}
+
+shared_vector *shared_vector::create(const uint32_t *first, const uint32_t *last, const size_t capacity,
+                                     memory_resource *resource) {
+    shared_vector *result = allocate(resource, resource);
+    storage_stats::count_allocation(0);
+    try {
+        result->data.reserve(capacity);
+        result->data.assign(first, last);
+    } catch (...) {
+        destroy(result);
+        throw;
+    }
+    storage_stats::count_resize(0, result->data.capacity());
+    return result;
+}
+
+shared_vector *shared_vector::create(const shared_vector &other) {
+    shared_vector *result = allocate(other.resource(), other);
+    storage_stats::count_allocation(result->data.capacity());
+    return result;
+}
+
+shared_vector *shared_vector::create_view(const uint32_t *first, const size_t size, memory_resource *resource) {
+    storage_stats::count_allocation(0);
+    return allocate(resource, first, size, resource);
+}
+
+void shared_vector::destroy(shared_vector *p) {
+    memory_resource *resource = p->resource();
+    storage_stats::count_resize(p->data.capacity(), 0);
+    p->~shared_vector();
+    resource->deallocate(p, sizeof(shared_vector), alignof(shared_vector));
+}
+
+memory_resource *shared_vector::resource() const {
+    return data.get_allocator().resource();
+}
+
+const uint32_t *shared_vector::limbs() const {
+    return view ? view : data.data();
+}
+
+bool shared_vector::is_view() const {
+    return view != nullptr;
+}
@@ -1,22 +1,61 @@
+#include "memory_resource.h"
+#include <atomic>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 #ifndef BIGINT_shared_vector_H
 #define BIGINT_shared_vector_H
 
 struct shared_vector {
+    ///  @typedefs
+public:
+    using storage = std::vector<uint32_t, resource_allocator<uint32_t>>;
+
     ///  @variables
 public:
-    std::vector<uint32_t> data;  ///  shared data
+    storage data;  ///  shared data, empty for a view
+    const uint32_t *view;  ///  borrowed read-only limbs of a view, nullptr if data owns the limbs
+    size_t view_size;
     size_t ref_count;  ///  number of references on shared data
+    ///  cached hash of data, 0 if not computed; owners reset it before modification. Atomic, because const
+    ///  hash() of copies sharing this buffer may fill it from several threads; relaxed is enough, as every
+    ///  writer stores the same value
+    std::atomic<size_t> hash;
 
     ///  @methods
 public:
-    explicit shared_vector(size_t size, uint32_t val);
+    ///  shared_vector and its data are allocated from the same resource
+    static shared_vector *create(size_t size, uint32_t val, memory_resource *resource = get_default_resource());
+
+    static shared_vector *create(const uint32_t *first, const uint32_t *last, size_t capacity,
+                                 memory_resource *resource = get_default_resource());
+
+    static shared_vector *create(const shared_vector &other);  ///  owning copy in the resource of other
+
+    ///  read-only view of external limbs, that must outlive it; owners copy it before modification
+    static shared_vector *create_view(const uint32_t *first, size_t size,
+                                      memory_resource *resource = get_default_resource());
+
+    static void destroy(shared_vector *p);
 
-    explicit shared_vector(std::vector<uint32_t> other_data);
+    memory_resource *resource() const;
+
+    const uint32_t *limbs() const;  ///  data of either an owning vector or a view
+
+    bool is_view() const;
+
+private:
+    explicit shared_vector(size_t size, uint32_t val, memory_resource *resource);
+
+    explicit shared_vector(memory_resource *resource);
 
     shared_vector(const shared_vector &other);
+
+    shared_vector(const uint32_t *first, size_t size, memory_resource *resource);
+
+    template<typename... Args>
+    static shared_vector *allocate(memory_resource *resource, Args &&... args);
 };
 
 #endif //BIGINT_shared_vector_H
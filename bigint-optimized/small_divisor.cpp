@@ -0,0 +1,82 @@
+#include "small_divisor.h"
+#include <stdexcept>
+
+namespace {
+    __extension__ typedef unsigned __int128 uint128;
+
+    ///  limb i of the dividend shifted left by shift < 32, the bits of limb i - 1 included
+    inline uint32_t shifted_limb(const uint32_t *a, const size_t i, const uint32_t shift) {
+        const uint64_t window = (static_cast<uint64_t>(a[i]) << 32u) | (i > 0 ? a[i - 1] : 0);
+        return static_cast<uint32_t>(window >> (32 - shift));
+    }
+}
+
+small_divisor::small_divisor(const uint32_t d) : divisor(d), shift(0), normalized(0), reciprocal(0) {
+    if (d == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    shift = static_cast<uint32_t>(__builtin_clz(d));
+    normalized = static_cast<uint64_t>(d << shift) << 32u;
+    ///  2^128 - 1 - 2^64 * normalized = (2^64 - 1 - normalized) * 2^64 + 2^64 - 1
+    reciprocal = static_cast<uint64_t>(((static_cast<uint128>(~normalized) << 64u) | UINT64_MAX) / normalized);
+}
+
+uint32_t small_divisor::value() const {
+    return divisor;
+}
+
+inline uint64_t small_divisor::divide_step(const uint64_t high, const uint64_t low, uint32_t &rem) const {
+    const uint128 estimate = static_cast<uint128>(reciprocal) * high + ((static_cast<uint128>(high) << 64u) | low);
+    uint64_t q = static_cast<uint64_t>(estimate >> 64u) + 1;
+    uint64_t r = low - q * normalized;
+    ///  the estimate is one too large in about half of the steps, so the correction is branchless
+    const uint64_t mask = 0 - static_cast<uint64_t>(r > static_cast<uint64_t>(estimate));
+    q += mask;
+    r += mask & normalized;
+    if (r >= normalized) {  ///  one too small, rare
+        ++q;
+        r -= normalized;
+    }
+    rem = static_cast<uint32_t>(r >> 32u);
+    return q;
+}
+
+uint32_t small_divisor::divide(const uint32_t *a, const size_t n, uint32_t *q) const {
+    if (n == 0) {
+        return 0;
+    }
+    ///  the dividend is shifted together with the divisor on the fly, its top shift bits are the initial remainder;
+    ///  every step divides rem * 2^64 + two shifted limbs, each limb is read before its quotient limb is written
+    uint32_t rem = static_cast<uint32_t>((static_cast<uint64_t>(a[n - 1]) << shift) >> 32u);
+    size_t i = n;
+    if (i % 2 == 1) {
+        --i;
+        q[i] = static_cast<uint32_t>(divide_step(rem, static_cast<uint64_t>(shifted_limb(a, i, shift)) << 32u, rem));
+    }
+    while (i > 0) {
+        i -= 2;
+        const uint64_t high = (static_cast<uint64_t>(rem) << 32u) | shifted_limb(a, i + 1, shift);
+        const uint64_t quotient = divide_step(high, static_cast<uint64_t>(shifted_limb(a, i, shift)) << 32u, rem);
+        q[i + 1] = static_cast<uint32_t>(quotient >> 32u);
+        q[i] = static_cast<uint32_t>(quotient);
+    }
+    return rem >> shift;
+}
+
+uint32_t small_divisor::remainder(const uint32_t *a, const size_t n) const {
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t rem = static_cast<uint32_t>((static_cast<uint64_t>(a[n - 1]) << shift) >> 32u);
+    size_t i = n;
+    if (i % 2 == 1) {
+        --i;
+        divide_step(rem, static_cast<uint64_t>(shifted_limb(a, i, shift)) << 32u, rem);
+    }
+    while (i > 0) {
+        i -= 2;
+        const uint64_t high = (static_cast<uint64_t>(rem) << 32u) | shifted_limb(a, i + 1, shift);
+        divide_step(high, static_cast<uint64_t>(shifted_limb(a, i, shift)) << 32u, rem);
+    }
+    return rem >> shift;
+}
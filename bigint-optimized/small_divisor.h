@@ -0,0 +1,34 @@
+#include <cstddef>
+#include <cstdint>
+
+#ifndef BIGINT_SMALL_DIVISOR_H
+#define BIGINT_SMALL_DIVISOR_H
+
+///  Positive divisor of one limb with a precomputed reciprocal (Moller, Granlund, "Improved division
+///  by invariant integers"): after the single division in the constructor every two limbs of the dividend
+///  cost two multiplications instead of two hardware divisions. Worth keeping for repeated divisions
+///  by the same constant, e.g. 10, 10^9 or 1000000007.
+struct small_divisor {
+    ///  @variables
+private:
+    uint32_t divisor;
+    uint32_t shift;  ///  divisor << shift has the top bit set
+    uint64_t normalized;  ///  (divisor << shift) * 2^32, so that two limbs are divided per step
+    uint64_t reciprocal;  ///  floor((2^128 - 1) / normalized) - 2^64
+
+    ///  @methods
+public:
+    explicit small_divisor(uint32_t d);  ///  throws std::runtime_error on zero
+
+    uint32_t value() const;
+
+    uint32_t divide(const uint32_t *a, size_t n, uint32_t *q) const;  ///  q[0, n) = a[0, n) / d, q may be a, returns remainder
+
+    uint32_t remainder(const uint32_t *a, size_t n) const;  ///  a[0, n) mod d
+
+private:
+    ///  (high * 2^64 + low) / normalized, high < normalized; the remainder is a multiple of 2^32, rem gets its top half
+    uint64_t divide_step(uint64_t high, uint64_t low, uint32_t &rem) const;
+};
+
+#endif //BIGINT_SMALL_DIVISOR_H
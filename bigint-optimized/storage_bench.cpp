@@ -0,0 +1,172 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <atomic>
+#include <new>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+///  The same workloads are compiled twice: against bigint/ (std::vector storage) as storage_bench_plain and
+///  against bigint-optimized/ as storage_bench_optimized, the include path selects the implementation.
+///  Both binaries share only the common interface of the two big_integer, so there is no ODR conflict.
+#include <big_integer.h>
+
+#ifndef STORAGE_BENCH_VARIANT
+#define STORAGE_BENCH_VARIANT "unknown"
+#endif
+
+namespace {
+    std::atomic<size_t> heap_allocations(0);
+}
+
+void *operator new(size_t size) {
+    ++heap_allocations;
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    using bench_clock = std::chrono::steady_clock;
+
+    ///  deterministic numbers of the given length in limbs, identical for both implementations
+    big_integer make_number(std::mt19937 &gen, size_t limbs) {
+        big_integer a(static_cast<int>(gen() >> 1u) + 1);
+        for (size_t i = 1; i < limbs; ++i) {
+            a <<= 32;
+            a += big_integer(static_cast<uint32_t>(gen()));
+        }
+        return a;
+    }
+
+    ///  1000 numbers of 64 limbs, built once before timing
+    const std::vector<big_integer> &numbers() {
+        static const std::vector<big_integer> v = [] {
+            std::mt19937 gen(1);
+            std::vector<big_integer> result;
+            for (size_t i = 0; i < 1000; ++i) {
+                result.push_back(make_number(gen, 64));
+            }
+            return result;
+        }();
+        return v;
+    }
+
+    ///  numbers are copied around and only read: containers, pass by value, comparisons
+    size_t copy_heavy(size_t rounds) {
+        const std::vector<big_integer> &v = numbers();
+        size_t ops = 0, checksum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            std::vector<big_integer> copy(v);
+            for (size_t i = 0; i + 1 < copy.size(); ++i) {
+                big_integer x = copy[i];
+                checksum += x < copy[i + 1];
+                ops += 2;
+            }
+        }
+        return ops + (checksum & 1u);
+    }
+
+    ///  every copy is modified in place right after copying
+    size_t mutate_heavy(size_t rounds) {
+        const std::vector<big_integer> &v = numbers();
+        size_t ops = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto &a : v) {
+                big_integer x = a;
+                x += a;
+                ++x;
+                x *= big_integer(3);
+                ops += 4;
+            }
+        }
+        return ops;
+    }
+
+    ///  int-sized values: counters, small products and remainders
+    size_t small_value_heavy(size_t rounds) {
+        std::mt19937 gen(2);
+        std::vector<big_integer> v;
+        for (size_t i = 0; i < 1000; ++i) {
+            v.emplace_back(static_cast<int>(gen() % 100000));
+        }
+        const big_integer m(1000000007);
+        size_t ops = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            for (size_t i = 0; i + 1 < v.size(); ++i) {
+                v[i] = (v[i] * v[i + 1] + big_integer(1)) % m;
+                ops += 3;
+            }
+        }
+        return ops;
+    }
+
+    struct mix {
+        const char *name;
+        size_t (*run)(size_t rounds);
+        size_t rounds;
+    };
+
+    const mix mixes[] = {
+            {"copy_heavy", copy_heavy, 200},
+            {"mutate_heavy", mutate_heavy, 200},
+            {"small_value_heavy", small_value_heavy, 2000},
+    };
+
+    ///  runs in a child process, so that ru_maxrss belongs to this mix only
+    void run_mix(const mix &m) {
+        numbers();
+        const size_t allocations = heap_allocations;
+        const auto start = bench_clock::now();
+        const size_t ops = m.run(m.rounds);
+        const double elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        std::cout << STORAGE_BENCH_VARIANT << ',' << m.name << ',' << static_cast<uint64_t>(ops / elapsed) << ','
+                  << static_cast<double>(heap_allocations - allocations) / ops << ',' << usage.ru_maxrss << std::endl;
+    }
+}
+
+///  usage: storage_bench_{plain,optimized} [--no-header] [mix...], without mixes runs everything
+int main(int argc, char **argv) {
+    bool header = true, all = true;
+    for (int i = 1; i < argc; ++i) {
+        header &= std::strcmp(argv[i], "--no-header") != 0;
+        all &= std::strcmp(argv[i], "--no-header") == 0;
+    }
+    if (header) {
+        std::cout << "variant,mix,ops_per_second,allocations_per_op,peak_rss_kb" << std::endl;
+    }
+    for (const auto &m : mixes) {
+        bool selected = all;
+        for (int i = 1; i < argc; ++i) {
+            selected |= std::strcmp(argv[i], m.name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+        const pid_t child = fork();
+        if (child == 0) {
+            run_mix(m);
+            std::exit(0);
+        }
+        waitpid(child, nullptr, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "storage_stats.h"
+#include <ostream>
+
+constexpr bool storage_stats::ENABLED;
+
+std::atomic<size_t> storage_stats::heap_allocations(0);
+std::atomic<size_t> storage_stats::promotions(0);
+std::atomic<size_t> storage_stats::deep_copies(0);
+std::atomic<size_t> storage_stats::demotions(0);
+std::atomic<size_t> storage_stats::bytes_copied(0);
+std::atomic<size_t> storage_stats::limbs_in_use(0);
+std::atomic<size_t> storage_stats::peak_limbs(0);
+
+storage_stats::snapshot storage_stats::get() {
+    return {heap_allocations.load(), promotions.load(), deep_copies.load(), demotions.load(), bytes_copied.load(),
+            limbs_in_use.load(), peak_limbs.load()};
+}
+
+void storage_stats::reset() {
+    heap_allocations = 0;
+    promotions = 0;
+    deep_copies = 0;
+    demotions = 0;
+    bytes_copied = 0;
+    peak_limbs = limbs_in_use.load();
+}
+
+void storage_stats::print(std::ostream &out) {
+    if (!ENABLED) {
+        out << "storage_stats: disabled, build with -DBIGINT_STORAGE_STATS=ON" << std::endl;
+        return;
+    }
+    const snapshot s = get();
+    out << "storage_stats: heap_allocations=" << s.heap_allocations << " promotions=" << s.promotions
+        << " deep_copies=" << s.deep_copies << " demotions=" << s.demotions << " bytes_copied=" << s.bytes_copied
+        << " limbs_in_use=" << s.limbs_in_use << " peak_limbs=" << s.peak_limbs << std::endl;
+}
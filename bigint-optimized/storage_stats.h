@@ -0,0 +1,98 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#ifndef BIGINT_STORAGE_STATS_H
+#define BIGINT_STORAGE_STATS_H
+
+#ifndef BIGINT_STORAGE_STATS
+#define BIGINT_STORAGE_STATS 0  ///  1 enables the counters, otherwise every count_* call compiles to nothing
+#endif
+
+///  Counters of heap storage events of optimized_storage and shared_vector, shared by all threads
+struct storage_stats {
+    ///  @typedefs
+public:
+    struct snapshot {
+        size_t heap_allocations;  ///  shared_vector nodes created
+        size_t promotions;  ///  numbers moved from static storage to the heap
+        size_t deep_copies;  ///  shared or viewed data copied by make_unshared
+        size_t demotions;  ///  numbers moved from the heap back to static storage
+        size_t bytes_copied;  ///  limbs copied by promotions, deep copies and demotions
+        size_t limbs_in_use;  ///  capacity of live heap buffers
+        size_t peak_limbs;  ///  maximum of limbs_in_use since the last reset
+    };
+
+    ///  @consts
+public:
+    static constexpr bool ENABLED = BIGINT_STORAGE_STATS != 0;
+
+    ///  @variables
+private:
+    static std::atomic<size_t> heap_allocations;
+    static std::atomic<size_t> promotions;
+    static std::atomic<size_t> deep_copies;
+    static std::atomic<size_t> demotions;
+    static std::atomic<size_t> bytes_copied;
+    static std::atomic<size_t> limbs_in_use;
+    static std::atomic<size_t> peak_limbs;
+
+    ///  @methods
+public:
+    static snapshot get();
+
+    static void reset();  ///  zeroes the event counters, peak restarts from the current usage
+
+    static void print(std::ostream &out);  ///  one line "storage_stats: name=value ...", or a note that it's disabled
+
+    static void count_allocation(size_t capacity) {
+#if BIGINT_STORAGE_STATS
+        heap_allocations.fetch_add(1, std::memory_order_relaxed);
+        count_resize(0, capacity);
+#else
+        static_cast<void>(capacity);
+#endif
+    }
+
+    static void count_resize(size_t old_capacity, size_t new_capacity) {
+#if BIGINT_STORAGE_STATS
+        const size_t now = limbs_in_use.fetch_add(new_capacity - old_capacity, std::memory_order_relaxed)
+                + new_capacity - old_capacity;
+        size_t peak = peak_limbs.load(std::memory_order_relaxed);
+        while (now > peak && !peak_limbs.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+#else
+        static_cast<void>(old_capacity);
+        static_cast<void>(new_capacity);
+#endif
+    }
+
+    static void count_promotion(size_t limbs_copied) {
+#if BIGINT_STORAGE_STATS
+        promotions.fetch_add(1, std::memory_order_relaxed);
+        bytes_copied.fetch_add(limbs_copied * sizeof(uint32_t), std::memory_order_relaxed);
+#else
+        static_cast<void>(limbs_copied);
+#endif
+    }
+
+    static void count_deep_copy(size_t limbs_copied) {
+#if BIGINT_STORAGE_STATS
+        deep_copies.fetch_add(1, std::memory_order_relaxed);
+        bytes_copied.fetch_add(limbs_copied * sizeof(uint32_t), std::memory_order_relaxed);
+#else
+        static_cast<void>(limbs_copied);
+#endif
+    }
+
+    static void count_demotion(size_t limbs_copied) {
+#if BIGINT_STORAGE_STATS
+        demotions.fetch_add(1, std::memory_order_relaxed);
+        bytes_copied.fetch_add(limbs_copied * sizeof(uint32_t), std::memory_order_relaxed);
+#else
+        static_cast<void>(limbs_copied);
+#endif
+    }
+};
+
+#endif //BIGINT_STORAGE_STATS_H
@@ -0,0 +1,121 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+    thread_local const thread_pool *current_pool = nullptr;
+    thread_local size_t current_queue = 0;
+}
+
+struct thread_pool::batch {
+    std::atomic<size_t> remaining;
+    std::mutex m;
+    std::exception_ptr error;
+
+    explicit batch(size_t n) : remaining(n) {}
+
+    void execute(const task &f) {
+        try {
+            f();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        --remaining;  ///  last access to *this, run() may return right after it
+    }
+};
+
+thread_pool::thread_pool(size_t threads) : queued(0), stop(false) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        queues.emplace_back(new worker_queue());
+    }
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(&thread_pool::worker_loop, this, i);
+    }
+}
+
+thread_pool::~thread_pool() {
+    stop = true;
+    {
+        std::lock_guard<std::mutex> lock(sleep_m);
+    }
+    wake.notify_all();
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+
+size_t thread_pool::size() const {
+    return queues.size();
+}
+
+void thread_pool::run(std::vector<task> &tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    batch b(tasks.size());
+    for (size_t i = 1; i < tasks.size(); ++i) {
+        push({std::move(tasks[i]), &b});
+    }
+    b.execute(tasks[0]);
+    while (b.remaining != 0) {
+        if (!try_execute()) {
+            std::this_thread::yield();
+        }
+    }
+    if (b.error) {
+        std::rethrow_exception(b.error);
+    }
+}
+
+void thread_pool::push(job j) {
+    worker_queue &q = *queues[current_pool == this ? current_queue : 0];
+    {
+        std::lock_guard<std::mutex> lock(q.m);
+        q.jobs.push_back(std::move(j));
+    }
+    ++queued;
+    {
+        std::lock_guard<std::mutex> lock(sleep_m);
+    }
+    wake.notify_one();
+}
+
+bool thread_pool::try_execute() {
+    const size_t own = current_pool == this ? current_queue : 0;
+    job j;
+    bool found = false;
+    for (size_t k = 0; k < queues.size() && !found; ++k) {
+        worker_queue &q = *queues[(own + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.jobs.empty()) {
+            continue;
+        } else if (k == 0) {  ///  own queue is used as a stack for better locality
+            j = std::move(q.jobs.back());
+            q.jobs.pop_back();
+        } else {
+            j = std::move(q.jobs.front());
+            q.jobs.pop_front();
+        }
+        found = true;
+    }
+    if (found) {
+        --queued;
+        j.owner->execute(j.f);
+    }
+    return found;
+}
+
+void thread_pool::worker_loop(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (!stop) {
+        if (!try_execute()) {
+            std::unique_lock<std::mutex> lock(sleep_m);
+            wake.wait(lock, [this] { return stop || queued != 0; });
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef BIGINT_THREAD_POOL_H
+#define BIGINT_THREAD_POOL_H
+
+///  Work-stealing pool: every worker owns a deque, takes own tasks from the back
+///  and steals from the front of the others. A thread waiting in run() executes
+///  tasks itself, so nested run() calls from inside tasks do not deadlock.
+struct thread_pool {
+    ///  @typedefs
+public:
+    using task = std::function<void()>;
+
+private:
+    struct batch;
+
+    struct job {
+        task f;
+        batch *owner;
+    };
+
+    struct worker_queue {
+        std::mutex m;
+        std::deque<job> jobs;
+    };
+
+    ///  @variables
+private:
+    std::vector<std::unique_ptr<worker_queue>> queues;  ///  queues[0] is shared by external threads
+    std::vector<std::thread> workers;
+    std::mutex sleep_m;
+    std::condition_variable wake;
+    std::atomic<size_t> queued;  ///  number of jobs in all queues
+    std::atomic<bool> stop;
+
+    ///  @methods
+public:
+    explicit thread_pool(size_t threads);  ///  threads includes the calling thread, so threads - 1 workers are started
+
+    thread_pool(const thread_pool &) = delete;
+
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool();
+
+    size_t size() const;
+
+    void run(std::vector<task> &tasks);  ///  runs all tasks, returns when all are done, rethrows the first exception
+
+private:
+    void push(job j);
+
+    bool try_execute();  ///  executes one job from own queue or steals one, false if nothing found
+
+    void worker_loop(size_t index);
+};
+
+#endif //BIGINT_THREAD_POOL_H
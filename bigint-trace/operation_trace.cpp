@@ -0,0 +1,179 @@
+#include "operation_trace.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+
+constexpr bool operation_trace::ENABLED;
+constexpr size_t operation_trace::SIZE_BUCKETS;
+constexpr size_t operation_trace::LATENCY_BUCKETS;
+
+namespace {
+    using histogram = operation_trace::histogram;
+
+    const size_t COUNTERS = 2 + operation_trace::SIZE_BUCKETS + operation_trace::LATENCY_BUCKETS;
+
+    struct thread_buffer;
+
+    struct registry {
+        std::mutex mutex;
+        std::vector<thread_buffer *> live;
+        uint64_t finished[operation_trace::OPERATIONS][COUNTERS];  ///  merged buffers of finished threads
+    };
+
+    registry &get_registry() {
+        static registry r{};
+        return r;
+    }
+
+    ///  counters of one thread in the layout of histogram, written only by the owner,
+    ///  atomic only to be read by collect() from other threads
+    struct thread_buffer {
+        std::atomic<uint64_t> counters[operation_trace::OPERATIONS][COUNTERS];
+
+        thread_buffer() {
+            for (auto &op : counters) {
+                for (auto &c : op) {
+                    c.store(0, std::memory_order_relaxed);
+                }
+            }
+            registry &r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.live.push_back(this);
+        }
+
+        ~thread_buffer() {
+            registry &r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (size_t op = 0; op < operation_trace::OPERATIONS; ++op) {
+                for (size_t i = 0; i < COUNTERS; ++i) {
+                    r.finished[op][i] += counters[op][i].load(std::memory_order_relaxed);
+                }
+            }
+            r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+        }
+
+        void add(const operation_trace::operation op, const size_t i, const uint64_t value) {
+            std::atomic<uint64_t> &c = counters[op][i];
+            c.store(c.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    };
+
+    thread_local size_t depth = 0;
+
+    thread_buffer &local_buffer() {
+        thread_local thread_buffer buffer;
+        return buffer;
+    }
+
+    histogram to_histogram(const uint64_t *counters) {
+        histogram h{};
+        h.calls = counters[0];
+        h.total_ns = counters[1];
+        std::copy(counters + 2, counters + 2 + operation_trace::SIZE_BUCKETS, h.sizes);
+        std::copy(counters + 2 + operation_trace::SIZE_BUCKETS, counters + COUNTERS, h.latencies);
+        return h;
+    }
+
+    ///  upper bound of the bucket that contains the given fraction of calls
+    uint64_t percentile(const histogram &h, const double fraction) {
+        uint64_t seen = 0;
+        for (size_t k = 0; k < operation_trace::LATENCY_BUCKETS; ++k) {
+            seen += h.latencies[k];
+            if (seen >= fraction * h.calls) {
+                return static_cast<uint64_t>(1) << k;
+            }
+        }
+        return static_cast<uint64_t>(1) << (operation_trace::LATENCY_BUCKETS - 1);
+    }
+}
+
+operation_trace::scope::scope(const operation op, const size_t size) : op(op), size(size), outermost(depth++ == 0) {
+    if (outermost) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+operation_trace::scope::~scope() {
+    --depth;
+    if (!outermost) {
+        return;
+    }
+    const auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    thread_buffer &buffer = local_buffer();
+    buffer.add(op, 0, 1);
+    buffer.add(op, 1, ns);
+    buffer.add(op, 2 + bucket(size, SIZE_BUCKETS), 1);
+    buffer.add(op, 2 + SIZE_BUCKETS + bucket(ns, LATENCY_BUCKETS), 1);
+}
+
+std::vector<operation_trace::histogram> operation_trace::collect() {
+    registry &r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<histogram> result;
+    for (size_t op = 0; op < OPERATIONS; ++op) {
+        uint64_t counters[COUNTERS];
+        std::copy(r.finished[op], r.finished[op] + COUNTERS, counters);
+        for (const thread_buffer *buffer : r.live) {
+            for (size_t i = 0; i < COUNTERS; ++i) {
+                counters[i] += buffer->counters[op][i].load(std::memory_order_relaxed);
+            }
+        }
+        result.push_back(to_histogram(counters));
+    }
+    return result;
+}
+
+void operation_trace::reset() {
+    registry &r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto &op : r.finished) {
+        std::fill(op, op + COUNTERS, 0);
+    }
+    for (thread_buffer *buffer : r.live) {
+        for (auto &op : buffer->counters) {
+            for (auto &c : op) {
+                c.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void operation_trace::print(std::ostream &out) {
+    if (!ENABLED) {
+        out << "operation_trace: disabled, build with -DBIGINT_TRACE=ON" << std::endl;
+        return;
+    }
+    const std::vector<histogram> all = collect();
+    for (size_t op = 0; op < OPERATIONS; ++op) {
+        const histogram &h = all[op];
+        if (h.calls == 0) {
+            continue;
+        }
+        out << "operation_trace: " << name(static_cast<operation>(op)) << " calls=" << h.calls
+            << " mean_ns=" << h.total_ns / h.calls << " p50_ns<=" << percentile(h, 0.5)
+            << " p99_ns<=" << percentile(h, 0.99) << " sizes=";
+        for (size_t k = 0; k < SIZE_BUCKETS; ++k) {
+            if (h.sizes[k] == 0) {
+                continue;
+            } else if (k + 1 == SIZE_BUCKETS) {
+                out << ">=" << (static_cast<uint64_t>(1) << (k - 1)) << ':' << h.sizes[k];
+            } else {
+                out << '<' << (static_cast<uint64_t>(1) << k) << ':' << h.sizes[k] << ' ';
+            }
+        }
+        out << std::endl;
+    }
+}
+
+const char *operation_trace::name(const operation op) {
+    static const char *const names[] = {"add", "sub", "mul", "div", "mod", "shift", "bitwise", "to_string",
+                                        "from_string"};
+    return names[op];
+}
+
+size_t operation_trace::bucket(const uint64_t value, const size_t buckets) {
+    const size_t k = value == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(value));
+    return std::min(k, buckets - 1);
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#ifndef BIGINT_OPERATION_TRACE_H
+#define BIGINT_OPERATION_TRACE_H
+
+#ifndef BIGINT_TRACE
+#define BIGINT_TRACE 0  ///  1 enables BIGINT_TRACE_SCOPE, otherwise it compiles to nothing
+#endif
+
+///  Per-operation call counts, operand size and latency histograms of big_integer.
+///  Every thread writes into its own buffer, collect() sums the buffers of running and finished threads.
+///  Has no dependencies on big_integer, so both bigint/ and bigint-optimized/ are instrumented with it.
+struct operation_trace {
+    ///  @typedefs
+public:
+    enum operation {
+        ADD, SUB, MUL, DIV, MOD, SHIFT, BITWISE, TO_STRING, FROM_STRING, OPERATIONS
+    };
+
+    ///  @consts
+public:
+    static constexpr bool ENABLED = BIGINT_TRACE != 0;
+    static constexpr size_t SIZE_BUCKETS = 24;  ///  bucket k holds sizes in [2^(k-1), 2^k), the last one - all larger
+    static constexpr size_t LATENCY_BUCKETS = 40;  ///  the same in nanoseconds
+
+    struct histogram {
+        uint64_t calls;
+        uint64_t total_ns;
+        uint64_t sizes[SIZE_BUCKETS];  ///  operand size in limbs, for FROM_STRING - in characters
+        uint64_t latencies[LATENCY_BUCKETS];
+    };
+
+    ///  Measures the time until the end of the scope. Only the outermost scope of a thread records,
+    ///  so operations implemented through other operations are counted once, with their full latency.
+    struct scope {
+        ///  @variables
+    private:
+        operation op;
+        size_t size;
+        bool outermost;
+        std::chrono::steady_clock::time_point start;
+
+        ///  @methods
+    public:
+        scope(operation op, size_t size);
+
+        scope(const scope &) = delete;
+
+        scope &operator=(const scope &) = delete;
+
+        ~scope();
+    };
+
+    ///  @methods
+public:
+    static std::vector<histogram> collect();  ///  indexed by operation, aggregated over all threads
+
+    static void reset();  ///  not synchronized with operations running in other threads
+
+    static void print(std::ostream &out);  ///  one line per called operation: calls, latency, size histogram
+
+    static const char *name(operation op);
+
+    static size_t bucket(uint64_t value, size_t buckets);  ///  histogram bucket of value, see SIZE_BUCKETS
+};
+
+#if BIGINT_TRACE
+#define BIGINT_TRACE_SCOPE(op, size) operation_trace::scope bigint_trace_scope(operation_trace::op, (size))
+#else
+#define BIGINT_TRACE_SCOPE(op, size) static_cast<void>(0)
+#endif
+
+#endif //BIGINT_OPERATION_TRACE_H
@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include <climits>
+#include "operation_trace.h"
 
 big_integer::big_integer() : data(1), sign(false) {}
 
@@ -17,6 +18,7 @@ big_integer::big_integer(const int a) : data(1), sign(a < 0) {
 big_integer::big_integer(const uint32_t a) : data(1, a), sign(false) {}
 
 big_integer::big_integer(const std::string &str) : big_integer() {
+    BIGINT_TRACE_SCOPE(FROM_STRING, str.size());
     if (str.empty()) {
         throw std::runtime_error("Expected: integer, found: empty string");
     }
@@ -69,6 +71,7 @@ uint32_t big_integer::high32_bits(const uint64_t a) {
 }
 
 big_integer &big_integer::operator+=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(ADD, std::max(size(), rhs.size()));
     if (sign && !rhs.sign) {
         return *this = rhs - (-*this);
     } else if (!sign && rhs.sign) {
@@ -90,6 +93,7 @@ big_integer &big_integer::operator+=(const big_integer &rhs) {
 }
 
 big_integer &big_integer::operator-=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(SUB, std::max(size(), rhs.size()));
     if (sign && !rhs.sign) {
         return *this = -(rhs - *this);
     } else if (!sign && rhs.sign) {
@@ -136,6 +140,7 @@ uint32_t big_integer::clear_log2() const {
 }
 
 big_integer &big_integer::operator*=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(MUL, std::max(size(), rhs.size()));
     if (!sign && count() == 1) {
         return *this = rhs << clear_log2();
     } else if (!rhs.sign && rhs.count() == 1) {
@@ -195,6 +200,7 @@ void big_integer::difference(const big_integer &dq, const uint64_t k, const uint
 }
 
 big_integer &big_integer::operator/=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(DIV, std::max(size(), rhs.size()));
     if (size() < rhs.size()) {
         return *this = 0;
     } else if (rhs.size() == 1) {
@@ -226,6 +232,7 @@ big_integer &big_integer::operator/=(const big_integer &rhs) {
 }
 
 big_integer &big_integer::operator%=(const big_integer &rhs) {
+    BIGINT_TRACE_SCOPE(MOD, std::max(size(), rhs.size()));
     return *this -= (*this / rhs) * rhs;
 }
 
@@ -242,6 +249,7 @@ void big_integer::to_additional_code(const size_t n_digits) {
 
 big_integer &
 big_integer::bitwise_operation(const big_integer &rhs, const func &f) {
+    BIGINT_TRACE_SCOPE(BITWISE, std::max(size(), rhs.size()));
     big_integer ans(*this), tmp_rhs(rhs);
     const size_t max_size = std::max(size(), rhs.size());
     ans.to_additional_code(max_size);
@@ -271,6 +279,7 @@ big_integer &big_integer::operator^=(const big_integer &rhs) {
 }
 
 big_integer &big_integer::operator<<=(const int b) {
+    BIGINT_TRACE_SCOPE(SHIFT, size());
     if (b < 0) {
         return *this >>= (-b);
     }
@@ -292,6 +301,7 @@ big_integer &big_integer::operator<<=(const int b) {
 }
 
 big_integer &big_integer::operator>>=(const int b) {
+    BIGINT_TRACE_SCOPE(SHIFT, size());
     if (b < 0) {
         return *this <<= (-b);
     }
@@ -425,6 +435,7 @@ bool operator>=(const big_integer &a, const big_integer &b) {
 }
 
 std::string to_string(const big_integer &a) {
+    BIGINT_TRACE_SCOPE(TO_STRING, a.size());
     if (a == 0) {
         return "0";
     }